@@ -0,0 +1,71 @@
+#pragma once
+
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+*/
+
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace hillvallea
+{
+
+  // allocator that aligns its memory to a cache line (64 bytes), so that
+  // rows in contiguous blocks can be processed with aligned (SIMD) loads.
+  //-------------------------------------------------------------------------------
+  template <typename T>
+  class aligned_allocator_t
+  {
+
+  public:
+
+    typedef T value_type;
+    static const size_t alignment = 64;
+
+    aligned_allocator_t() {}
+    template <typename U> aligned_allocator_t(const aligned_allocator_t<U> &) {}
+
+    T * allocate(size_t n)
+    {
+      void * p = nullptr;
+      if (n == 0) {
+        n = 1;
+      }
+      if (posix_memalign(&p, alignment, n * sizeof(T)) != 0) {
+        throw std::bad_alloc();
+      }
+      return static_cast<T *>(p);
+    }
+
+    void deallocate(T * p, size_t) {
+      free(p);
+    }
+
+    template <typename U> struct rebind { typedef aligned_allocator_t<U> other; };
+
+  };
+
+  template <typename T, typename U>
+  bool operator==(const aligned_allocator_t<T> &, const aligned_allocator_t<U> &) { return true; }
+
+  template <typename T, typename U>
+  bool operator!=(const aligned_allocator_t<T> &, const aligned_allocator_t<U> &) { return false; }
+
+  // contiguous, 64-byte aligned array of doubles
+  typedef std::vector<double, aligned_allocator_t<double>> aligned_vec_t;
+
+  // number of doubles in a row of n doubles padded to a multiple of the alignment
+  inline size_t aligned_leading_dimension(size_t n)
+  {
+    const size_t doubles_per_line = aligned_allocator_t<double>::alignment / sizeof(double);
+    return ((n + doubles_per_line - 1) / doubles_per_line) * doubles_per_line;
+  }
+
+}
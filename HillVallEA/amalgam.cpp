@@ -51,6 +51,7 @@ hillvallea::optimizer_pt hillvallea::amalgam_t::clone() const
   opt->number_of_generations = number_of_generations;
   opt->rng = rng;
   opt->pop = std::make_shared<population_t>(); //!! A copy of the contents, not the pointer
+  opt->pop->solution_pool = pop->solution_pool;
   opt->pop->addSolutions(*pop);
   opt->best = best;
   opt->average_fitness_history = average_fitness_history;
@@ -61,7 +62,9 @@ hillvallea::optimizer_pt hillvallea::amalgam_t::clone() const
   //----------------------------------------------------------------------------------
   opt->maximum_no_improvement_stretch = maximum_no_improvement_stretch;
   opt->param_std_tolerance = param_std_tolerance;     
-  opt->fitness_std_tolerance = fitness_std_tolerance; 
+  opt->fitness_std_tolerance = fitness_std_tolerance;
+  opt->number_of_drawn_samples = number_of_drawn_samples;
+  opt->number_of_rejected_samples = number_of_rejected_samples; 
 
   // AMaLGaM data members
   //-------------------------------------------
@@ -228,8 +231,7 @@ void hillvallea::amalgam_t::estimate_sample_parameters()
   cholesky.multiply(sqrt(multiplier));
 
   // invert the cholesky decomposition
-  int n = (int)covariance.rows();
-  inverse_cholesky.setRaw(matrixLowerTriangularInverse(cholesky.toArray(), n), n, n);
+  matrixLowerTriangularInverse(cholesky, inverse_cholesky);
   
 }
 
@@ -239,7 +241,8 @@ size_t hillvallea::amalgam_t::sample_new_population(const size_t sample_size)
 
   // Sample new population
   //----------------------------------------------------------------------------------------
-  int number_of_samples = pop->fill_normal(sample_size, number_of_parameters, mean, cholesky, lower_param_bounds, upper_param_bounds, 1, rng);
+  int number_of_samples = pop->fill_normal(sample_size, number_of_parameters, mean, cholesky, lower_param_bounds, upper_param_bounds, 1, rng->stream(number_of_generations), number_of_rejected_samples);
+  number_of_drawn_samples += number_of_samples;
 
   // apply the AMS
   if (apply_ams)
@@ -302,38 +305,22 @@ double hillvallea::amalgam_t::getSDR(const solution_t & best, const vec_t & mean
 void hillvallea::amalgam_t::apply_ams_to_population(const size_t number_of_ams_solutions, const double ams_factor, const vec_t & ams_direction)
 {
 
-  // we have a shrink factor in case the shifts are
-  // outside of the parameter bounds
-  double shrink_factor;
-  int attempts = 0;
-
   // loop over the first solutions to shift them,
   // but we save the elite.
   for (size_t i = 1; i < std::min(number_of_ams_solutions + 1, pop->sols.size()); ++i)
   {
-
-    // try to sample within bounds
-    shrink_factor = 2;
-
-    // shift x.
-    vec_t ams_params = pop->sols[i]->param;
-    ams_params += shrink_factor * ams_factor * ams_direction;
-
     boundary_repair(pop->sols[i]->param, lower_param_bounds, upper_param_bounds);
 
+    // the shift is 2 * ams_factor * ams_direction, halved until the shifted
+    // solution is in range. The largest such shrink factor follows directly from
+    // the distance to the bounds along the shift.
+    double shrink_factor = ams_shrink_factor(pop->sols[i]->param, ams_factor, ams_direction, lower_param_bounds, upper_param_bounds);
 
-    // try smaller shifts until the sol is within range
-    while (attempts < 100 && !in_range(ams_params, lower_param_bounds, upper_param_bounds))
+    if (shrink_factor > 0.0)
     {
-
-      // if not, decrease the shrink_factor
-      attempts++;
-      shrink_factor *= 0.5;
-      ams_params -= shrink_factor * ams_factor * ams_direction;
-
-    }
-
-    if (attempts < 100) {
+      vec_t ams_params = pop->sols[i]->param;
+      ams_params += shrink_factor * ams_factor * ams_direction;
+      boundary_repair(ams_params, lower_param_bounds, upper_param_bounds);
       pop->sols[i]->param = ams_params;
     }
 
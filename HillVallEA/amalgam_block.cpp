@@ -0,0 +1,520 @@
+/*
+
+AMaLGaM-Block as part of HillVallEA
+
+Implementation by S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+
+*/
+
+#include "population.hpp"
+#include "mathfunctions.hpp"
+#include "fitness.h"
+#include "amalgam_block.hpp"
+
+
+// init amalgam default parameters
+hillvallea::amalgam_block_t::amalgam_block_t(const size_t number_of_parameters, const vec_t & lower_param_bounds, const vec_t & upper_param_bounds, double init_univariate_bandwidth, fitness_pt fitness_function, rng_pt rng) : optimizer_t(number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, rng)
+{
+
+  // default values for AMaLGaM
+  maximum_no_improvement_stretch = (int)(number_of_parameters + 25);
+  selection_fraction = 0.35;
+  st_dev_ratio_threshold = 1.0;
+  distribution_multiplier_decrease = 0.9;
+  sample_succes_ratio_threshold = 0.1;
+  param_std_tolerance = 1e-12;
+  fitness_std_tolerance = 1e-12;
+
+  apply_ams = true;
+  delta_ams = 2.0;
+
+  // the linkage model
+  std::vector<std::vector<size_t>> user_blocks;
+  if (fitness_function != nullptr) {
+    fitness_function->get_linkage_blocks(user_blocks);
+  }
+
+  learn_linkage = (user_blocks.size() == 0);
+  linkage_significance = 3.0;
+  set_blocks(user_blocks);
+
+}
+
+hillvallea::amalgam_block_t::~amalgam_block_t(){};
+
+
+
+hillvallea::optimizer_pt hillvallea::amalgam_block_t::clone() const
+{
+
+  amalgam_block_pt opt = std::make_shared<amalgam_block_t>(number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, rng);
+
+  // Optimizer data members
+  //-------------------------------------------
+  opt->active = active;
+  opt->number_of_parameters = number_of_parameters;
+  opt->lower_param_bounds = lower_param_bounds;
+  opt->upper_param_bounds = upper_param_bounds;
+  opt->fitness_function = fitness_function;
+  opt->number_of_generations = number_of_generations;
+  opt->rng = rng;
+  opt->pop = std::make_shared<population_t>(); //!! A copy of the contents, not the pointer
+  opt->pop->solution_pool = pop->solution_pool;
+  opt->pop->addSolutions(*pop);
+  opt->best = best;
+  opt->average_fitness_history = average_fitness_history;
+  opt->selection_fraction = selection_fraction;
+  opt->init_univariate_bandwidth = init_univariate_bandwidth;
+
+  // Stopping criteria
+  //----------------------------------------------------------------------------------
+  opt->maximum_no_improvement_stretch = maximum_no_improvement_stretch;
+  opt->param_std_tolerance = param_std_tolerance;
+  opt->fitness_std_tolerance = fitness_std_tolerance;
+  opt->number_of_drawn_samples = number_of_drawn_samples;
+  opt->number_of_rejected_samples = number_of_rejected_samples;
+
+  // AMaLGaM data members
+  //-------------------------------------------
+  opt->mean = mean;
+  opt->blocks = blocks;
+  opt->covariance = covariance;
+  opt->cholesky = cholesky;
+  opt->inverse_cholesky = inverse_cholesky;
+  opt->learn_linkage = learn_linkage;
+  opt->linkage_significance = linkage_significance;
+  opt->no_improvement_stretch = no_improvement_stretch;
+  opt->multiplier = multiplier;
+  opt->old_mean = old_mean;
+  opt->st_dev_ratio_threshold = st_dev_ratio_threshold;
+  opt->distribution_multiplier_decrease = distribution_multiplier_decrease;
+  opt->sample_succes_ratio_threshold = sample_succes_ratio_threshold;
+  opt->delta_ams = delta_ams;
+  opt->apply_ams = apply_ams;
+
+  return opt;
+}
+
+
+
+// Algorithm Name
+std::string hillvallea::amalgam_block_t::name() const { return "AMaLGaM-Block"; }
+
+// Initial initialization of the algorithm
+// Population should be sorted on fitness (fittest first)
+void hillvallea::amalgam_block_t::initialize_from_population(population_pt pop)
+{
+  this->pop = pop;
+
+  multiplier = 1.0;
+  no_improvement_stretch = 0;
+  pop->mean(old_mean);
+  mean = old_mean;
+  pop->sort_on_fitness();
+  best = *pop->sols[0];
+
+}
+
+// the univariate population size, or that of the full AMaLGaM for the largest given block
+size_t hillvallea::amalgam_block_t::recommended_popsize(const size_t problem_dimension) const
+{
+  size_t largest_block_size = 1;
+  if (!learn_linkage)
+  {
+    for (size_t b = 0; b < blocks.size(); ++b) {
+      largest_block_size = std::max(largest_block_size, blocks[b].size());
+    }
+  }
+
+  double univariate_popsize = 10.0*pow((double)problem_dimension, 0.5);
+  double block_popsize = 17.0 + 3.0*pow((double)largest_block_size, 1.5);
+
+  return (size_t)std::max((double)((size_t)((2.0 / selection_fraction) + 1)), std::max(univariate_popsize, block_popsize));
+}
+
+void hillvallea::amalgam_block_t::set_blocks(const std::vector<std::vector<size_t>> & user_blocks)
+{
+  std::vector<bool> assigned(number_of_parameters, false);
+  blocks.clear();
+
+  for (size_t b = 0; b < user_blocks.size(); ++b)
+  {
+    if (user_blocks[b].size() == 0) {
+      continue;
+    }
+
+    for (size_t i = 0; i < user_blocks[b].size(); ++i)
+    {
+      assert(user_blocks[b][i] < number_of_parameters);
+      assert(!assigned[user_blocks[b][i]]); // the blocks must be disjoint
+      assigned[user_blocks[b][i]] = true;
+    }
+
+    blocks.push_back(user_blocks[b]);
+  }
+
+  for (size_t i = 0; i < number_of_parameters; ++i)
+  {
+    if (!assigned[i]) {
+      blocks.push_back(std::vector<size_t>(1, i));
+    }
+  }
+}
+
+// Links are tested on the Fisher transform of the sample correlation, atanh(r) * sqrt(n - 3),
+// which is approximately standard normal if the parameters are independent. The critical
+// value is raised to sqrt(2 ln(number of pairs)), at which less than one false link is expected.
+// The strongest links are merged first, up to the largest block for which the population
+// size (n / selection_fraction) is at least that recommended for the full AMaLGaM.
+// Time is O(n d^2) for a selection of size n, memory is O(n d) plus the links.
+void hillvallea::amalgam_block_t::learn_blocks()
+{
+  size_t n = pop->size();
+  std::vector<std::vector<size_t>> learned_blocks;
+
+  if (n <= 3) {
+    set_blocks(learned_blocks);
+    return;
+  }
+
+  vec_t population_mean;
+  pop->mean(population_mean);
+
+  // the standardized parameters, one contiguous row per parameter
+  std::vector<vec_t> standardized(number_of_parameters, vec_t(n, 0.0));
+  for (size_t i = 0; i < number_of_parameters; ++i)
+  {
+    double norm = 0.0;
+    for (size_t k = 0; k < n; ++k)
+    {
+      standardized[i][k] = pop->sols[k]->param[i] - population_mean[i];
+      norm += standardized[i][k] * standardized[i][k];
+    }
+
+    if (norm > 0.0) {
+      standardized[i] /= sqrt(norm);
+    }
+  }
+
+  // the significant links
+  double number_of_pairs = 0.5 * number_of_parameters * (number_of_parameters - 1.0);
+  double critical_value = std::max(linkage_significance, sqrt(2.0 * log(std::max(number_of_pairs, 1.0))));
+  double correlation_threshold = tanh(critical_value / sqrt(n - 3.0));
+  std::vector<std::pair<double, std::pair<size_t, size_t>>> links;
+
+  for (size_t i = 0; i < number_of_parameters; ++i)
+  {
+    for (size_t j = i + 1; j < number_of_parameters; ++j)
+    {
+      double correlation = 0.0;
+      for (size_t k = 0; k < n; ++k) {
+        correlation += standardized[i][k] * standardized[j][k];
+      }
+
+      if (fabs(correlation) > correlation_threshold) {
+        links.push_back(std::make_pair(fabs(correlation), std::make_pair(i, j)));
+      }
+    }
+  }
+
+  std::sort(links.begin(), links.end(), [](const std::pair<double, std::pair<size_t, size_t>> & a, const std::pair<double, std::pair<size_t, size_t>> & b) { return a.first > b.first; });
+
+  // merge the blocks (union-find)
+  double population_size = n / selection_fraction;
+  size_t maximum_block_size = (size_t)std::max(1.0, floor(pow(std::max(population_size - 17.0, 0.0) / 3.0, 2.0 / 3.0)));
+  maximum_block_size = std::min(maximum_block_size, n - 1);
+  std::vector<size_t> parent(number_of_parameters), block_size(number_of_parameters, 1);
+  for (size_t i = 0; i < number_of_parameters; ++i) {
+    parent[i] = i;
+  }
+
+  auto root = [&parent](size_t i)
+  {
+    while (parent[i] != i)
+    {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  };
+
+  for (size_t l = 0; l < links.size(); ++l)
+  {
+    size_t a = root(links[l].second.first);
+    size_t b = root(links[l].second.second);
+
+    if (a != b && block_size[a] + block_size[b] <= maximum_block_size)
+    {
+      if (a > b) {
+        std::swap(a, b);
+      }
+
+      parent[b] = a;
+      block_size[a] += block_size[b];
+    }
+  }
+
+  // the blocks, in order of their first parameter
+  std::vector<size_t> block_index(number_of_parameters, number_of_parameters);
+  for (size_t i = 0; i < number_of_parameters; ++i)
+  {
+    size_t r = root(i);
+    if (block_index[r] == number_of_parameters)
+    {
+      block_index[r] = learned_blocks.size();
+      learned_blocks.push_back(std::vector<size_t>());
+    }
+
+    learned_blocks[block_index[r]].push_back(i);
+  }
+
+  set_blocks(learned_blocks);
+}
+
+void hillvallea::amalgam_block_t::update_distribution_multiplier(double & multiplier, const bool improvement, int & no_improvement_stretch, const double & sample_success_ratio, const double sdr) const
+{
+
+  // default variables;
+  double sample_succes_ratio_threshold = 0.10;
+
+  // if >90% of the samples is out of bounds, multiplier *0.5
+  if (sample_success_ratio < sample_succes_ratio_threshold)
+    multiplier *= 0.5;
+
+  if (improvement)
+  {
+    no_improvement_stretch = 0;
+
+    if (multiplier < 1.0)
+      multiplier = 1.0;
+
+    if (sdr > st_dev_ratio_threshold)
+      multiplier /= distribution_multiplier_decrease;
+
+  }
+  else
+  {
+
+    if (multiplier <= 1.0)
+      no_improvement_stretch++;
+
+    if (multiplier > 1.0 || no_improvement_stretch >= maximum_no_improvement_stretch)
+      multiplier *= distribution_multiplier_decrease;
+
+    if (multiplier < 1.0 && no_improvement_stretch < maximum_no_improvement_stretch)
+      multiplier = 1.0;
+
+  }
+}
+
+// returns true if any of the termination criteria is satisfied
+bool hillvallea::amalgam_block_t::checkTerminationCondition()
+{
+
+  if (number_of_generations == 0) {
+    active = true;
+    return !active;
+  }
+
+  // 1. if the cluster is empty, deactivate it.
+  if (pop->size() == 0) {
+    active = false;
+    return !active;
+  }
+
+  // 2. check the maximum parameter variance
+  // we scale the fitness std by it.
+  double max_param_variance = 0.0;
+  for (size_t b = 0; b < covariance.size(); ++b)
+  {
+    for (size_t i = 0; i < covariance[b].rows(); ++i) {
+      if (covariance[b][i][i] > max_param_variance) {
+        max_param_variance = covariance[b][i][i];
+      }
+    }
+  }
+
+  vec_t mean;
+  pop->mean(mean);
+
+  // if the mean equals zero, we can't didivide by it, so terminate it when it is kinda small
+  bool terminate_for_param_std_mean_zero = (mean.infinitynorm() <= 0 && sqrt(max_param_variance) < param_std_tolerance);
+  bool terminate_on_parameter_std = sqrt(max_param_variance) / mean.infinitynorm() < param_std_tolerance;
+  bool terminate_on_fitness_std = (pop->size() > 1) && (pop->relative_fitness_std() < fitness_std_tolerance);
+  bool terminate_on_distribution_multiplier = (multiplier < 1e-10);
+
+  if (terminate_for_param_std_mean_zero || terminate_on_parameter_std || terminate_on_fitness_std || terminate_on_distribution_multiplier)
+  {
+    active = false;
+    return !active;
+  }
+
+  // if we have not terminated so far, the cluster is active.
+  // if, due to selection, the cluster is shrunken, it is set to active again.
+  active = true;
+  return !active;
+
+}
+
+void hillvallea::amalgam_block_t::estimate_sample_parameters()
+{
+
+  // Compute sample mean and sample covariance
+  old_mean = mean;
+
+  // Change the focus of the search to the best solution
+  if (multiplier < 1.0)
+    mean = pop->sols[0]->param;
+  else
+    pop->mean(mean);
+
+  if (learn_linkage) {
+    learn_blocks();
+  }
+
+  covariance.resize(blocks.size());
+  cholesky.resize(blocks.size());
+  inverse_cholesky.resize(blocks.size());
+
+  for (size_t b = 0; b < blocks.size(); ++b)
+  {
+    size_t block_size = blocks[b].size();
+
+    // if the population size is too small,
+    // estimate a univariate covariance matrix
+    if (pop->size() == 1)
+    {
+      covariance[b].setIdentity(block_size, block_size);
+      covariance[b].multiply(init_univariate_bandwidth*0.01);
+    }
+    else
+    {
+      pop->covariance(mean, blocks[b], covariance[b]);
+
+      if (pop->size() <= block_size)
+      {
+        for (size_t i = 0; i < block_size; ++i)
+          for (size_t j = 0; j < block_size; ++j)
+            if (i != j)
+              covariance[b][i][j] = 0.0;
+      }
+    }
+
+    // Cholesky decomposition
+    choleskyDecomposition(covariance[b], cholesky[b]);
+
+    // apply the multiplier
+    cholesky[b].multiply(sqrt(multiplier));
+
+    // invert the cholesky decomposition
+    matrixLowerTriangularInverse(cholesky[b], inverse_cholesky[b]);
+  }
+
+}
+
+// sample a new population
+size_t hillvallea::amalgam_block_t::sample_new_population(const size_t sample_size)
+{
+
+  // Sample new population
+  //----------------------------------------------------------------------------------------
+  int number_of_samples = pop->fill_normal_blocks(sample_size, number_of_parameters, mean, blocks, cholesky, lower_param_bounds, upper_param_bounds, 1, rng->stream(number_of_generations), number_of_rejected_samples);
+  number_of_drawn_samples += number_of_samples;
+
+  // apply the AMS
+  if (apply_ams)
+  {
+    vec_t ams_direction = mean - old_mean;
+
+    size_t number_of_ams_solutions = (size_t)(0.5*selection_fraction*sample_size); // alpha ams
+    apply_ams_to_population(number_of_ams_solutions, delta_ams*multiplier, ams_direction); // ams, not to elite
+  }
+
+  // evaluate the population
+  //---------------------------------------------------------------------------------------
+  size_t number_of_evaluations = pop->evaluate(fitness_function, 1);
+  pop->sort_on_fitness();
+
+
+  // Update Params
+  //---------------------------------------------------------------------------------------
+  bool improvement = pop->improvement_over(best.f);
+  double sdr = getSDR(best, mean, inverse_cholesky);
+  double sample_success_ratio = (double)(sample_size - 1) / number_of_samples; // we do not sample the best.
+  update_distribution_multiplier(multiplier, improvement, no_improvement_stretch, sample_success_ratio, sdr);
+  best = *pop->first();
+
+  number_of_generations++;
+
+  return number_of_evaluations;
+}
+
+
+
+
+
+// Compute the SDR
+//--------------------------------------------------------------------------------------
+double hillvallea::amalgam_block_t::getSDR(const solution_t & best, const vec_t & mean, const std::vector<matrix_t> & inverse_chol) const
+{
+  size_t i;
+
+  // find improvements over the best.
+  vec_t average_params(number_of_parameters, 0.0);
+  for (i = 0; (i < pop->size()) && (pop->sols[i]->f < best.f); ++i) {
+    average_params += pop->sols[i]->param;
+  }
+
+  if (i == 0)
+    return 0.0;
+
+  average_params /= (double)i;
+
+  vec_t diff = average_params - mean;
+
+  // inverse_chol is block-diagonal
+  double sdr = 0.0;
+  for (size_t b = 0; b < blocks.size(); ++b)
+  {
+    vec_t block_diff(blocks[b].size());
+    for (size_t j = 0; j < blocks[b].size(); ++j) {
+      block_diff[j] = diff[blocks[b][j]];
+    }
+
+    sdr = std::max(sdr, inverse_chol[b].lowerProduct(block_diff).infinitynorm());
+  }
+
+  return sdr;
+
+}
+
+
+// Apply the Anticipated Mean Shift (AMS) to the first solutions (not the elite)
+//------------------------------------------------------------------------
+void hillvallea::amalgam_block_t::apply_ams_to_population(const size_t number_of_ams_solutions, const double ams_factor, const vec_t & ams_direction)
+{
+
+  // loop over the first solutions to shift them,
+  // but we save the elite.
+  for (size_t i = 1; i < std::min(number_of_ams_solutions + 1, pop->sols.size()); ++i)
+  {
+    boundary_repair(pop->sols[i]->param, lower_param_bounds, upper_param_bounds);
+
+    // the shift is 2 * ams_factor * ams_direction, halved until the shifted
+    // solution is in range. The largest such shrink factor follows directly from
+    // the distance to the bounds along the shift.
+    double shrink_factor = ams_shrink_factor(pop->sols[i]->param, ams_factor, ams_direction, lower_param_bounds, upper_param_bounds);
+
+    if (shrink_factor > 0.0)
+    {
+      vec_t ams_params = pop->sols[i]->param;
+      ams_params += shrink_factor * ams_factor * ams_direction;
+      boundary_repair(ams_params, lower_param_bounds, upper_param_bounds);
+      pop->sols[i]->param = ams_params;
+    }
+
+  }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+/*
+
+AMaLGaM-Block as part of HillVallEA
+
+Implementation by S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+
+*/
+
+#include "hillvallea_internal.hpp"
+#include "optimizer.hpp"
+
+namespace hillvallea
+{
+
+  // AMaLGaM with a block-diagonal covariance matrix, in between the full (amalgam_t)
+  // and univariate (amalgam_univariate_t) versions. The blocks partition the parameters
+  // and are estimated, decomposed and sampled independently, at O(sum b^2) memory and
+  // O(sum b^3) decomposition time for blocks of size b.
+  // The partition is taken from fitness_function->get_linkage_blocks. If that is empty,
+  // it is learned every generation from the selection: parameters are linked if their
+  // correlation is significant, merging the strongest links first, up to blocks that
+  // are small enough to be estimated from the selection.
+  //-------------------------------------------------------------------------------
+  class amalgam_block_t : public optimizer_t
+  {
+
+  public:
+
+    // C++ Rule of Three
+    //-------------------------------------------
+    amalgam_block_t(const size_t number_of_parameters, const vec_t & lower_param_bounds, const vec_t & upper_param_bounds, double init_univariate_bandwidth, fitness_pt fitness_function, rng_pt rng);
+    ~amalgam_block_t();
+    optimizer_pt clone() const;
+
+    // Essential data members
+    //-------------------------------------------
+    vec_t mean;                                 // sample mean
+    std::vector<std::vector<size_t>> blocks;    // partition of the parameters
+    std::vector<matrix_t> covariance;           // sample covariance matrix C, per block
+    std::vector<matrix_t> cholesky;             // decomposed covariance matrix C = LL^T, per block
+    std::vector<matrix_t> inverse_cholesky;     // inverse of the cholesky decomposition, per block
+
+    // Linkage learning
+    //-------------------------------------------
+    bool learn_linkage;                         // false if the blocks are given by the fitness function
+    double linkage_significance;                // in standard deviations of the Fisher transformed correlation
+
+    // Transferrable parameters
+    //-------------------------------------------
+    int no_improvement_stretch;
+    double multiplier;
+    vec_t old_mean;
+
+    // Stopping criteria
+    //-------------------------------------------
+    double st_dev_ratio_threshold;
+    double distribution_multiplier_decrease;
+    double sample_succes_ratio_threshold;
+
+    // AMS
+    //-------------------------------------------
+    double delta_ams;
+    bool apply_ams;
+
+    // Run-time control
+    //---------------------------------------------------------------------------------
+    bool checkTerminationCondition();
+    void estimate_sample_parameters();
+    size_t sample_new_population(const size_t sample_size);
+
+    // Initialization
+    //---------------------------------------------------------------------------------
+    void initialize_from_population(population_pt pop);
+    size_t recommended_popsize(const size_t problem_dimension) const;
+    void set_blocks(const std::vector<std::vector<size_t>> & user_blocks); // parameters that are not in any block become blocks of their own
+    void learn_blocks();
+
+    // AMS & SDR
+    //-------------------------------------------
+    void apply_ams_to_population(const size_t number_of_ams_solutions, const double ams_factor, const vec_t & ams_direction);
+    double getSDR(const solution_t & best, const vec_t & mean, const std::vector<matrix_t> & inverse_cholesky) const;
+    void update_distribution_multiplier(double & multiplier, const bool improvement, int & no_improvement_stretch, const double & sample_success_ratio, const double sdr) const;
+
+    // Debug info
+    //---------------------------------------------------------------------------------
+    std::string name() const;
+
+  };
+
+}
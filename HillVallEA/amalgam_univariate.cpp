@@ -47,6 +47,7 @@ hillvallea::optimizer_pt hillvallea::amalgam_univariate_t::clone() const
   opt->number_of_generations = number_of_generations;
   opt->rng = rng;
   opt->pop = std::make_shared<population_t>(); //!! A copy of the contents, not the pointer
+  opt->pop->solution_pool = pop->solution_pool;
   opt->pop->addSolutions(*pop);
   opt->best = best;
   opt->average_fitness_history = average_fitness_history;
@@ -58,6 +59,8 @@ hillvallea::optimizer_pt hillvallea::amalgam_univariate_t::clone() const
   opt->maximum_no_improvement_stretch = maximum_no_improvement_stretch; ;
   opt->param_std_tolerance = param_std_tolerance;
   opt->fitness_std_tolerance = fitness_std_tolerance;
+  opt->number_of_drawn_samples = number_of_drawn_samples;
+  opt->number_of_rejected_samples = number_of_rejected_samples;
 
   // AMaLGaM data members
   //-------------------------------------------
@@ -153,9 +156,9 @@ bool hillvallea::amalgam_univariate_t::checkTerminationCondition()
   // 2. check the maximum parameter variance
   // we scale the param std by it.
   double max_param_variance = 0.0;
-  for (size_t i = 0; i < covariance.rows(); ++i) {
-    if (covariance[i][i] > max_param_variance) {
-      max_param_variance = covariance[i][i];
+  for (size_t i = 0; i < covariance.size(); ++i) {
+    if (covariance[i] > max_param_variance) {
+      max_param_variance = covariance[i];
     }
   }
 
@@ -196,10 +199,11 @@ void hillvallea::amalgam_univariate_t::estimate_sample_parameters()
 
   // if the population size is too small,
   // estimate a univariate covariance matrix
+  // only the diagonals of the (diagonal) matrices are stored
   if (pop->size() == 1)
   {
-    covariance.setIdentity(mean.size(), mean.size());
-    covariance.multiply(init_univariate_bandwidth*0.01);
+    covariance.resize(mean.size());
+    covariance.fill(init_univariate_bandwidth*0.01);
   }
   else 
   {
@@ -209,11 +213,10 @@ void hillvallea::amalgam_univariate_t::estimate_sample_parameters()
   choleskyDecomposition_univariate(covariance, cholesky);
 
   // apply the multiplier
-  cholesky.multiply(sqrt(multiplier));
+  cholesky *= sqrt(multiplier);
 
   // invert the cholesky decomposition
-  int n = (int)covariance.rows();
-  inverse_cholesky.setRaw(matrixLowerTriangularInverse(cholesky.toArray(), n), n, n);
+  matrixDiagonalInverse(cholesky, inverse_cholesky);
   
 }
 
@@ -223,7 +226,8 @@ size_t hillvallea::amalgam_univariate_t::sample_new_population(const size_t samp
 
   // Sample new population
   //----------------------------------------------------------------------------------------
-  int number_of_samples = pop->fill_normal_univariate(sample_size, number_of_parameters, mean, cholesky, lower_param_bounds, upper_param_bounds, 1, rng);
+  int number_of_samples = pop->fill_normal_univariate(sample_size, number_of_parameters, mean, cholesky, lower_param_bounds, upper_param_bounds, 1, rng->stream(number_of_generations), number_of_rejected_samples);
+  number_of_drawn_samples += number_of_samples;
 
   // apply the AMS
   if (apply_ams)
@@ -258,7 +262,7 @@ size_t hillvallea::amalgam_univariate_t::sample_new_population(const size_t samp
 
 // Compute the SDR
 //--------------------------------------------------------------------------------------
-double hillvallea::amalgam_univariate_t::getSDR(const solution_t & best, const vec_t & mean, matrix_t & inverse_chol) const
+double hillvallea::amalgam_univariate_t::getSDR(const solution_t & best, const vec_t & mean, vec_t & inverse_chol) const
 {
   size_t i;
 
@@ -275,7 +279,13 @@ double hillvallea::amalgam_univariate_t::getSDR(const solution_t & best, const v
 
   vec_t diff = average_params - mean;
 
-  return inverse_chol.lowerProduct(diff).infinitynorm();
+  // inverse_chol is diagonal
+  double sdr = 0.0;
+  for (size_t j = 0; j < number_of_parameters; ++j) {
+    sdr = std::max(sdr, fabs(inverse_chol[j] * diff[j]));
+  }
+
+  return sdr;
 
 }
 
@@ -285,38 +295,22 @@ double hillvallea::amalgam_univariate_t::getSDR(const solution_t & best, const v
 void hillvallea::amalgam_univariate_t::apply_ams_to_population(const size_t number_of_ams_solutions, const double ams_factor, const vec_t & ams_direction)
 {
 
-  // we have a shrink factor in case the shifts are
-  // outside of the parameter bounds
-  double shrink_factor;
-  int attempts = 0;
-
   // loop over the first solutions to shift them,
   // but we save the elite.
   for (size_t i = 1; i < std::min(number_of_ams_solutions + 1, pop->sols.size()); ++i)
   {
-
-    // try to sample within bounds
-    shrink_factor = 2;
-
-    // shift x.
-    vec_t ams_params = pop->sols[i]->param;
-    ams_params += shrink_factor * ams_factor * ams_direction;
-
     boundary_repair(pop->sols[i]->param, lower_param_bounds, upper_param_bounds);
 
+    // the shift is 2 * ams_factor * ams_direction, halved until the shifted
+    // solution is in range. The largest such shrink factor follows directly from
+    // the distance to the bounds along the shift.
+    double shrink_factor = ams_shrink_factor(pop->sols[i]->param, ams_factor, ams_direction, lower_param_bounds, upper_param_bounds);
 
-    // try smaller shifts until the sol is within range
-    while (attempts < 100 && !in_range(ams_params, lower_param_bounds, upper_param_bounds))
+    if (shrink_factor > 0.0)
     {
-
-      // if not, decrease the shrink_factor
-      attempts++;
-      shrink_factor *= 0.5;
-      ams_params -= shrink_factor * ams_factor * ams_direction;
-
-    }
-
-    if (attempts < 100) {
+      vec_t ams_params = pop->sols[i]->param;
+      ams_params += shrink_factor * ams_factor * ams_direction;
+      boundary_repair(ams_params, lower_param_bounds, upper_param_bounds);
       pop->sols[i]->param = ams_params;
     }
 
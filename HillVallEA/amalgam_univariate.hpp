@@ -31,9 +31,9 @@ namespace hillvallea
     // Essential data members
     //-------------------------------------------
     vec_t mean;                       // sample mean
-    matrix_t covariance;              // sample covariance matrix C
-    matrix_t cholesky;                // decomposed covariance matrix C = LL^T
-    matrix_t inverse_cholesky;        // inverse of the cholesky decomposition
+    vec_t covariance;                 // diagonal of the sample covariance matrix C
+    vec_t cholesky;                   // diagonal of the decomposed covariance matrix C = LL^T
+    vec_t inverse_cholesky;           // diagonal of the inverse of the cholesky decomposition
 
     // Transferrable parameters
     //-------------------------------------------
@@ -63,7 +63,7 @@ namespace hillvallea
     // AMS & SDR
     //-------------------------------------------
     void apply_ams_to_population(const size_t number_of_ams_solutions, const double ams_factor, const vec_t & ams_direction);
-    double getSDR(const solution_t & best, const vec_t & mean, matrix_t & cholesky_factor) const;
+    double getSDR(const solution_t & best, const vec_t & mean, vec_t & cholesky_factor) const;
     void update_distribution_multiplier(double & multiplier, const bool improvement, double & no_improvement_stretch, const double & sample_success_ratio, const double sdr) const;
     
     // Debug info
@@ -11,6 +11,8 @@ smaree.com
 */
 #include "population.hpp"
 #include "mathfunctions.hpp"
+#include "linalg.hpp"
+#include "normal_generator.hpp"
 #include "cmsaes.hpp"
 
 
@@ -28,6 +30,12 @@ hillvallea::cmsaes_t::cmsaes_t(const size_t number_of_parameters, const vec_t &
   cholesky.setIdentity(number_of_parameters, number_of_parameters);
   covariance.setIdentity(number_of_parameters, number_of_parameters);
 
+  minimum_lazy_decomposition_dimension = 50;
+  decomposition_interval = 1;
+  generations_since_decomposition = 0;
+  maximum_decomposition_drift = 0.1;
+  decomposed_variances.resize(number_of_parameters, 1.0);
+
   size_t stallsize = (size_t)(10 + floor(30.0 * number_of_parameters / recommended_popsize(number_of_parameters)));  // Stall time(for termination criterion)
   bestf_NE.resize(stallsize, 0.0);
 
@@ -58,6 +66,7 @@ hillvallea::optimizer_pt hillvallea::cmsaes_t::clone() const
   opt->number_of_generations = number_of_generations;
   opt->rng = rng;
   opt->pop = std::make_shared<population_t>(); //!! A copy of the contents, not the pointer
+  opt->pop->solution_pool = pop->solution_pool;
   opt->pop->addSolutions(*pop);
   opt->best = best;
   // opt->number = number;
@@ -75,6 +84,8 @@ hillvallea::optimizer_pt hillvallea::cmsaes_t::clone() const
   opt->maximum_no_improvement_stretch = maximum_no_improvement_stretch;
   opt->param_std_tolerance = param_std_tolerance;
   opt->fitness_std_tolerance = fitness_std_tolerance;
+  opt->number_of_drawn_samples = number_of_drawn_samples;
+  opt->number_of_rejected_samples = number_of_rejected_samples;
 
   // CMA-ES Parameters
   //---------------------------------------------------------------------------------
@@ -87,6 +98,13 @@ hillvallea::optimizer_pt hillvallea::cmsaes_t::clone() const
   opt->mean = mean;
   opt->covariance = covariance;
   opt->cholesky = cholesky;
+  opt->minimum_lazy_decomposition_dimension = minimum_lazy_decomposition_dimension;
+  opt->decomposition_interval = decomposition_interval;
+  opt->generations_since_decomposition = generations_since_decomposition;
+  opt->maximum_decomposition_drift = maximum_decomposition_drift;
+  opt->decomposed_variances = decomposed_variances;
+  opt->multipliers = multipliers;
+  opt->params_transformed = params_transformed;
   opt->no_improvement_stretch = no_improvement_stretch;
 
 
@@ -169,6 +187,15 @@ void hillvallea::cmsaes_t::initStrategyParameters(size_t selection_size)
   tau = 1.0 / sqrt(2.0 * number_of_parameters);
   tau_c = 1 + number_of_parameters * (number_of_parameters + 1.0) / (selection_size) * TCovCoeff;
 
+  // C moves by a fraction 1/tau_c per generation. As the eigendecomposition in CMA-ES
+  // (Hansen, 2016), the decomposition is postponed until this adds up to 1/(2d),
+  // which is every 2-4 generations for d = 50-200. In lower dimensions, the O(d^3)
+  // decomposition is cheap and is done every generation.
+  decomposition_interval = 1;
+  if (number_of_parameters >= minimum_lazy_decomposition_dimension) {
+    decomposition_interval = (size_t)std::max(1.0, floor(tau_c / (2.0 * number_of_parameters)));
+  }
+
   // Weights
   weights.resize(mu);
   double sum_weights = 0.0;
@@ -225,6 +252,15 @@ void hillvallea::cmsaes_t::initialize_from_population(population_pt pop)
   }
 
   sigma = 1;
+
+  decomposed_variances.resize(number_of_parameters);
+  for (size_t i = 0; i < number_of_parameters; ++i) {
+    decomposed_variances[i] = covariance[i][i];
+  }
+  generations_since_decomposition = 0;
+
+  multipliers.assign(pop->size(), 1.0);
+  params_transformed.assign(pop->size(), vec_t(number_of_parameters, 0.0));
   
 }
 
@@ -257,8 +293,8 @@ void hillvallea::cmsaes_t::estimate_sample_parameters()
     double weighted_sum_logsigma = 0.0;
 
     for (size_t i = 0; i < pop->size(); ++i) {
-      weighted_sum_logsigma += weights[i] * log(pop->sols[i]->multiplier);
-      sum_logsigma += log(pop->sols[i]->multiplier); // actually, this should be of the whole pop before selection TODO
+      weighted_sum_logsigma += weights[i] * log(multipliers[i]);
+      sum_logsigma += log(multipliers[i]); // actually, this should be of the whole pop before selection TODO
     }
 
     sigma *= exp(weighted_sum_logsigma) / exp(sum_logsigma / pop->size());
@@ -266,28 +302,66 @@ void hillvallea::cmsaes_t::estimate_sample_parameters()
   }
 
   // sample covariance
-  estimate_covariance(covariance, cholesky);
+  estimate_covariance(covariance);
+
+  // decompose it, or keep sampling from the previous decomposition
+  generations_since_decomposition++;
+
+  if (generations_since_decomposition >= decomposition_interval || decomposition_drift() > maximum_decomposition_drift)
+  {
+    choleskyDecomposition(covariance, cholesky);
+
+    for (size_t i = 0; i < number_of_parameters; ++i) {
+      decomposed_variances[i] = covariance[i][i];
+    }
+    generations_since_decomposition = 0;
+  }
+
+}
+
+// the largest relative change of a variance since the last decomposition, O(d)
+double hillvallea::cmsaes_t::decomposition_drift() const
+{
+  double drift = 0.0;
+
+  for (size_t i = 0; i < number_of_parameters; ++i)
+  {
+    if (decomposed_variances[i] <= 0.0) {
+      return 1e308;
+    }
+
+    drift = std::max(drift, fabs(covariance[i][i] / decomposed_variances[i] - 1.0));
+  }
 
+  return drift;
 }
 
 
 
-void hillvallea::cmsaes_t::estimate_covariance(matrix_t & covariance, matrix_t & cholesky) const
+void hillvallea::cmsaes_t::estimate_covariance(matrix_t & covariance) const
 {
 
+  assert(params_transformed.size() >= pop->size());
+
   // init WG matrix by zeros
   matrix_t wgMatrix = matrix_t(number_of_parameters, number_of_parameters, 0.0);
 
-  // compute the wgMatrix
+  // pack the transformed parameters into one aligned block and
+  // compute the upper triangle of the wgMatrix by a weighted rank-k update
+  size_t ld = aligned_leading_dimension(number_of_parameters);
+  aligned_vec_t transformed(pop->size() * ld);
+
+  for (size_t k = 0; k < pop->size(); ++k) {
+    std::copy(params_transformed[k].begin(), params_transformed[k].end(), transformed.begin() + k * ld);
+  }
+
+  syrk_upper(transformed.data(), pop->size(), number_of_parameters, ld, weights.data(), wgMatrix);
+
   for (size_t i = 0; i < number_of_parameters; i++) {
-    for (size_t j = i; j < number_of_parameters; j++) {
-      for (size_t k = 0; k < pop->size(); ++k) {
-        wgMatrix[i][j] += weights[k] * (pop->sols[k]->param_transformed[i])*(pop->sols[k]->param_transformed[j]);
-      }
-      wgMatrix[j][i] = wgMatrix[i][j];
+    for (size_t j = 0; j < i; j++) {
+      wgMatrix[i][j] = wgMatrix[j][i];
     }
   }
-  
 
   // compute the covariance matrix
   // C <- (1-1/tau_c) * C + 1/tc <ss^T>
@@ -297,8 +371,6 @@ void hillvallea::cmsaes_t::estimate_covariance(matrix_t & covariance, matrix_t &
       covariance[j][i] = covariance[i][j];
     }
   }
-  
-  choleskyDecomposition(covariance, cholesky);
 
 }
 
@@ -362,6 +434,8 @@ size_t hillvallea::cmsaes_t::sample_new_population(const size_t sample_size)
   //--------------------------------------------
   size_t number_of_elites = 1;
   pop->sols.resize(sample_size);
+  multipliers.resize(sample_size, 1.0);
+  params_transformed.resize(sample_size, vec_t(number_of_parameters, 0.0));
 
   // for each sol in the pop, sample.
   for (size_t i = 0; i < pop->sols.size(); ++i)
@@ -374,57 +448,53 @@ size_t hillvallea::cmsaes_t::sample_new_population(const size_t sample_size)
     // if the solution is not yet initialized, do it now.
     if (pop->sols[i] == nullptr)
     {
-      solution_pt sol = std::make_shared<solution_t>(number_of_parameters);
+      solution_pt sol = pop->new_solution(number_of_parameters);
       pop->sols[i] = sol;
     }
 
-    // Sample independent standard normal variables Z = N(0,1)
-    // std::normal_distribution<double> std_normal(0.0, 1.0);
+    // Sample independent standard normal variables Z = N(0,1),
+    // from substream i of the stream of this generation
     vec_t z(number_of_parameters);
+    rng_t sample_rng = rng->stream(number_of_generations).stream(i);
 
-    // try to sample within bounds
-    bool sample_in_range = false;
-    int attempts = 0;
-    
     // sample a new solution
-    std::normal_distribution<double> std_normal(0.0, 1.0); // move this inside the for-loop below to match it with the CMA-ES code by Peter
-
-    // try using the normal distribution
-    while (!sample_in_range && attempts < 100)
-    {
-
+    standard_normals(sample_rng, z.data(), number_of_parameters);
 
-      for (size_t j = 0; j < number_of_parameters; ++j) {
-        z[j] = std_normal(*rng);
-      }
+    multipliers[i] = sigma * exp(tau * standard_normal(sample_rng));
+    params_transformed[i] = cholesky.product(z); // param_transformed = s_l in the CMSA paper. 
 
-      // pop->sols[i]->param_transformed = z;
-      // z *= sigma;
+    pop->sols[i]->param = mean + multipliers[i] * params_transformed[i];
 
-      pop->sols[i]->multiplier = sigma * exp(tau *std_normal(*rng));
-      pop->sols[i]->param_transformed = cholesky.product(z); // param_transformed = s_l in the CMSA paper. 
-
-      pop->sols[i]->param = mean + pop->sols[i]->multiplier * pop->sols[i]->param_transformed;
-      boundary_repair(pop->sols[i]->param, lower_param_bounds, upper_param_bounds);
-
-      sample_in_range = in_range(pop->sols[i]->param, lower_param_bounds, upper_param_bounds);
-      attempts++;
-
-    }
-    // if that fails, fall back to uniform from the initial user-defined range
-    if (!sample_in_range) {
-      sample_uniform(pop->sols[i]->param, number_of_parameters, lower_param_bounds, upper_param_bounds, rng);
-      pop->sols[i]->param_transformed = vec_t(number_of_parameters, 0.0);
-      std::cout << "Too many sample attempts. Sample uniform. (mathfunctions.cpp:105)" << std::endl;
+    // redraw the out-of-range coordinates from the truncated normal, keeping s_l consistent
+    if (!in_range(pop->sols[i]->param, lower_param_bounds, upper_param_bounds))
+    {
+      truncate_normal_sample(pop->sols[i]->param, z, number_of_parameters, mean, cholesky, multipliers[i], lower_param_bounds, upper_param_bounds, sample_rng);
+      params_transformed[i] = cholesky.product(z);
+      number_of_rejected_samples++;
     }
 
+    number_of_drawn_samples++;
+
   }
 
 
   // evaluate the population
   //---------------------------------------------------------------------------------------
   size_t number_of_evaluations = pop->evaluate(fitness_function, 1);
-  pop->sort_on_fitness();
+
+  // sort, and keep the strategy parameters in line with the solutions
+  std::vector<size_t> order;
+  pop->sort_on_fitness(order);
+
+  vec_t sorted_multipliers(order.size());
+  std::vector<vec_t> sorted_params_transformed(order.size());
+  for (size_t k = 0; k < order.size(); ++k)
+  {
+    sorted_multipliers[k] = multipliers[order[k]];
+    sorted_params_transformed[k].swap(params_transformed[order[k]]);
+  }
+  multipliers.swap(sorted_multipliers);
+  params_transformed.swap(sorted_params_transformed);
   // pop->setOrigin(this);
 
   // Update Params
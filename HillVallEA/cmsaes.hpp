@@ -40,6 +40,20 @@ namespace hillvallea
     matrix_t covariance;
     matrix_t cholesky;                // product matrix cholesky such that C = cholesky * (cholesky)^(-T)
 
+    // lazy decomposition: cholesky is recomputed every decomposition_interval generations,
+    // or earlier if a variance drifted more than maximum_decomposition_drift (relative)
+    // from decomposed_variances, the diagonal of C at the last decomposition.
+    // Below minimum_lazy_decomposition_dimension, it is recomputed every generation.
+    size_t minimum_lazy_decomposition_dimension;
+    size_t decomposition_interval;
+    size_t generations_since_decomposition;
+    double maximum_decomposition_drift;
+    vec_t decomposed_variances;
+
+    // per-solution strategy parameters, in line with pop->sols
+    vec_t multipliers;                   // mutation strength of each solution
+    std::vector<vec_t> params_transformed; // s_l in the CMSA paper
+
     double no_improvement_stretch; // a double as we average it a lot
 
     // Initialization
@@ -51,7 +65,8 @@ namespace hillvallea
     //---------------------------------------------------------------------------------
     bool checkTerminationCondition();
     void estimate_sample_parameters();
-    void estimate_covariance(matrix_t & covariance, matrix_t & BD) const;
+    void estimate_covariance(matrix_t & covariance) const;
+    double decomposition_drift() const;
     size_t sample_new_population(const size_t sample_size);
     void initStrategyParameters(const size_t selection_size);
 
@@ -0,0 +1,66 @@
+#pragma once
+
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+*/
+
+#include "hillvallea_internal.hpp"
+
+namespace hillvallea
+{
+
+  // Compile-time problem sizes
+  // At small problem sizes, the kernels on parameter vectors are dominated by loop
+  // overhead. They are therefore written as templates on the problem size D, and
+  // instantiated for the sizes that are common in practice (1-8, and the CEC2013
+  // sizes 10 and 20). D = 0 is the fallback for a size known only at runtime.
+  // The problem size is fixed for a run, so the dispatch below always takes the same branch.
+  //-------------------------------------------------------------------------------
+
+  // loop bound in a kernel instantiated for D
+  template <size_t D>
+  inline size_t fixed_dimension(size_t n)
+  {
+    return (D == 0) ? n : D;
+  }
+
+  // kernel_t::run<n> if n is one of the fixed sizes, kernel_t::run<0> otherwise.
+  // kernel_t defines function_t, the type of &kernel_t::run<D>.
+  template <typename kernel_t>
+  typename kernel_t::function_t dimension_dispatch(size_t n)
+  {
+    switch (n)
+    {
+      case 1: return &kernel_t::template run<1>;
+      case 2: return &kernel_t::template run<2>;
+      case 3: return &kernel_t::template run<3>;
+      case 4: return &kernel_t::template run<4>;
+      case 5: return &kernel_t::template run<5>;
+      case 6: return &kernel_t::template run<6>;
+      case 7: return &kernel_t::template run<7>;
+      case 8: return &kernel_t::template run<8>;
+      case 10: return &kernel_t::template run<10>;
+      case 20: return &kernel_t::template run<20>;
+      default: return &kernel_t::template run<0>;
+    }
+  }
+
+  // true if n is one of the fixed sizes
+  struct fixed_dimension_kernel_t
+  {
+    typedef bool (*function_t)();
+    template <size_t D> static bool run() { return D != 0; }
+  };
+
+  inline bool is_fixed_dimension(size_t n)
+  {
+    return dimension_dispatch<fixed_dimension_kernel_t>(n)();
+  }
+
+}
@@ -0,0 +1,212 @@
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+
+*/
+
+#include "distance.hpp"
+#include "dimension.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HILLVALLEA_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+namespace hillvallea
+{
+
+  typedef double (*squared_distance_function_t)(const double *, const double *, size_t);
+  typedef void (*squared_distances_function_t)(const double *, const double *, size_t, size_t, size_t, double *);
+
+  // Every kernel is instantiated for the fixed problem sizes (see dimension.hpp)
+  struct squared_distance_kernel_t
+  {
+    typedef squared_distance_function_t function_t;
+
+    template <size_t D>
+    static double run(const double * x, const double * y, size_t n)
+    {
+      n = fixed_dimension<D>(n);
+
+      double v = 0;
+      for (size_t i = 0; i < n; ++i) {
+        double diff = x[i] - y[i];
+        v += diff * diff;
+      }
+      return v;
+    }
+  };
+
+  double squared_distance(const double * x, const double * y, size_t n)
+  {
+    return dimension_dispatch<squared_distance_kernel_t>(n)(x, y, n);
+  }
+
+  struct squared_distances_scalar_t
+  {
+    typedef squared_distances_function_t function_t;
+
+    template <size_t D>
+    static void run(const double * x, const double * block, size_t m, size_t n, size_t ld, double * out)
+    {
+      for (size_t k = 0; k < m; ++k) {
+        out[k] = squared_distance_kernel_t::run<D>(x, block + k * ld, n);
+      }
+    }
+  };
+
+#ifdef HILLVALLEA_X86_DISPATCH
+
+  // The vector kernels handle several points at once, one point per lane, and add
+  // the dimensions in order. Contraction to fma is switched off (avx512f implies fma),
+  // so every lane performs exactly the scalar arithmetic.
+
+  // 4 points per step. Blocks of 4 dimensions x 4 points are transposed in registers.
+  struct squared_distances_avx2_t
+  {
+    typedef squared_distances_function_t function_t;
+
+    template <size_t D>
+    __attribute__((target("avx2"), optimize("fp-contract=off")))
+    static void run(const double * x, const double * block, size_t m, size_t n, size_t ld, double * out);
+  };
+
+  template <size_t D>
+  __attribute__((target("avx2"), optimize("fp-contract=off")))
+  void squared_distances_avx2_t::run(const double * x, const double * block, size_t m, size_t n, size_t ld, double * out)
+  {
+    n = fixed_dimension<D>(n);
+
+    size_t k = 0;
+    for (; k + 4 <= m; k += 4)
+    {
+      const double * p0 = block + k * ld;
+      const double * p1 = p0 + ld;
+      const double * p2 = p1 + ld;
+      const double * p3 = p2 + ld;
+
+      __m256d v = _mm256_setzero_pd();
+
+      size_t i = 0;
+      for (; i + 4 <= n; i += 4)
+      {
+        __m256d r0 = _mm256_loadu_pd(p0 + i);
+        __m256d r1 = _mm256_loadu_pd(p1 + i);
+        __m256d r2 = _mm256_loadu_pd(p2 + i);
+        __m256d r3 = _mm256_loadu_pd(p3 + i);
+
+        // transpose, so that column c holds dimension i + c of the 4 points
+        __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+        __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+        __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+        __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+
+        __m256d c0 = _mm256_permute2f128_pd(t0, t2, 0x20);
+        __m256d c1 = _mm256_permute2f128_pd(t1, t3, 0x20);
+        __m256d c2 = _mm256_permute2f128_pd(t0, t2, 0x31);
+        __m256d c3 = _mm256_permute2f128_pd(t1, t3, 0x31);
+
+        __m256d d;
+        d = _mm256_sub_pd(_mm256_set1_pd(x[i]), c0);     v = _mm256_add_pd(v, _mm256_mul_pd(d, d));
+        d = _mm256_sub_pd(_mm256_set1_pd(x[i + 1]), c1); v = _mm256_add_pd(v, _mm256_mul_pd(d, d));
+        d = _mm256_sub_pd(_mm256_set1_pd(x[i + 2]), c2); v = _mm256_add_pd(v, _mm256_mul_pd(d, d));
+        d = _mm256_sub_pd(_mm256_set1_pd(x[i + 3]), c3); v = _mm256_add_pd(v, _mm256_mul_pd(d, d));
+      }
+
+      for (; i < n; ++i)
+      {
+        __m256d c = _mm256_set_pd(p3[i], p2[i], p1[i], p0[i]);
+        __m256d d = _mm256_sub_pd(_mm256_set1_pd(x[i]), c);
+        v = _mm256_add_pd(v, _mm256_mul_pd(d, d));
+      }
+
+      _mm256_storeu_pd(out + k, v);
+    }
+
+    squared_distances_scalar_t::run<D>(x, block + k * ld, m - k, n, ld, out + k);
+  }
+
+  // 8 points per step, the dimensions of the 8 points are gathered.
+  struct squared_distances_avx512_t
+  {
+    typedef squared_distances_function_t function_t;
+
+    template <size_t D>
+    __attribute__((target("avx512f"), optimize("fp-contract=off")))
+    static void run(const double * x, const double * block, size_t m, size_t n, size_t ld, double * out);
+  };
+
+  template <size_t D>
+  __attribute__((target("avx512f"), optimize("fp-contract=off")))
+  void squared_distances_avx512_t::run(const double * x, const double * block, size_t m, size_t n, size_t ld, double * out)
+  {
+    n = fixed_dimension<D>(n);
+
+    const __m512i offsets = _mm512_set_epi64(7 * (long long) ld, 6 * (long long) ld, 5 * (long long) ld, 4 * (long long) ld, 3 * (long long) ld, 2 * (long long) ld, (long long) ld, 0);
+
+    size_t k = 0;
+    for (; k + 8 <= m; k += 8)
+    {
+      const double * p = block + k * ld;
+      __m512d v = _mm512_setzero_pd();
+
+      for (size_t i = 0; i < n; ++i)
+      {
+        __m512d c = _mm512_i64gather_pd(offsets, p + i, 8);
+        __m512d d = _mm512_sub_pd(_mm512_set1_pd(x[i]), c);
+        v = _mm512_add_pd(v, _mm512_mul_pd(d, d));
+      }
+
+      _mm512_storeu_pd(out + k, v);
+    }
+
+    squared_distances_scalar_t::run<D>(x, block + k * ld, m - k, n, ld, out + k);
+  }
+
+#endif
+
+  // instruction set, with the instantiations for all problem sizes
+  struct squared_distances_kernel_t
+  {
+    squared_distances_function_t (*select)(size_t n);
+    const char * isa;
+  };
+
+  // picks the kernel once, on first use
+  static const squared_distances_kernel_t & squared_distances_kernel()
+  {
+    static const squared_distances_kernel_t kernel = []()
+    {
+#ifdef HILLVALLEA_X86_DISPATCH
+      __builtin_cpu_init();
+
+      if (__builtin_cpu_supports("avx512f")) {
+        return squared_distances_kernel_t{ dimension_dispatch<squared_distances_avx512_t>, "avx512" };
+      }
+
+      if (__builtin_cpu_supports("avx2")) {
+        return squared_distances_kernel_t{ dimension_dispatch<squared_distances_avx2_t>, "avx2" };
+      }
+#endif
+      return squared_distances_kernel_t{ dimension_dispatch<squared_distances_scalar_t>, "scalar" };
+    }();
+
+    return kernel;
+  }
+
+  void squared_distances(const double * x, const double * block, size_t m, size_t n, size_t ld, double * out)
+  {
+    squared_distances_kernel().select(n)(x, block, m, n, ld, out);
+  }
+
+  const char * squared_distances_isa()
+  {
+    return squared_distances_kernel().isa;
+  }
+
+}
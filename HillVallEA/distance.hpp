@@ -0,0 +1,35 @@
+#pragma once
+
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+*/
+
+#include "hillvallea_internal.hpp"
+
+namespace hillvallea
+{
+
+  // Distance kernels
+  // All distances are summed over the dimensions in order, (x[0]-y[0])^2 + (x[1]-y[1])^2 + ...,
+  // so that sqrt(squared_distance(x,y)) equals (x - y).norm() exactly.
+  //-------------------------------------------------------------------------------
+
+  // squared Euclidean distance between x and y
+  double squared_distance(const double * x, const double * y, size_t n);
+
+  // squared distances from x to the m points stored row-major in block, with
+  // leading dimension ld: out[k] = squared_distance(x, block + k * ld, n).
+  // The points are processed in groups with AVX-512 or AVX2 if the cpu supports it,
+  // which gives the same result as the scalar version.
+  void squared_distances(const double * x, const double * block, size_t m, size_t n, size_t ld, double * out);
+
+  // name of the instruction set used by squared_distances ("avx512", "avx2" or "scalar")
+  const char * squared_distances_isa();
+
+}
@@ -0,0 +1,161 @@
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+
+*/
+
+#include "elitist_archive.hpp"
+
+namespace hillvallea
+{
+
+  elitist_archive_t::elitist_archive_t()
+  {
+    clear();
+  }
+
+  elitist_archive_t::~elitist_archive_t() {}
+
+  size_t elitist_archive_t::size() const
+  {
+    return sols.size();
+  }
+
+  const solution_pt & elitist_archive_t::operator[](size_t i) const
+  {
+    return sols[i];
+  }
+
+  std::vector<solution_pt>::const_iterator elitist_archive_t::begin() const
+  {
+    return sols.begin();
+  }
+
+  std::vector<solution_pt>::const_iterator elitist_archive_t::end() const
+  {
+    return sols.end();
+  }
+
+  elitist_archive_t::operator const std::vector<solution_pt> & () const
+  {
+    return sols;
+  }
+
+  void elitist_archive_t::clear()
+  {
+    sols.clear();
+    tree = nullptr;
+    tree_index.clear();
+    archive_index.clear();
+
+    best_fitness_index = 0;
+    best_solution_index = 0;
+    max_generation_obtained_index = 0;
+  }
+
+  void elitist_archive_t::push_back(const solution_pt & sol)
+  {
+    if (tree == nullptr) {
+      tree = std::make_shared<kdtree_t>(sol->param.size());
+    }
+
+    sols.push_back(sol);
+    tree_index.push_back(tree->insert(sol->param));
+    archive_index.push_back(sols.size() - 1);
+
+    update_aggregates(sols.size() - 1);
+  }
+
+  void elitist_archive_t::replace(size_t i, const solution_pt & sol)
+  {
+    assert(i < sols.size());
+
+    sols[i] = sol;
+
+    archive_index[tree_index[i]] = (size_t) -1;
+    tree_index[i] = tree->insert(sol->param);
+    archive_index.push_back(i);
+
+    // the replaced elite might have been the one an aggregate was based on
+    recompute_aggregates();
+  }
+
+  size_t elitist_archive_t::nearest(const solution_t & sol) const
+  {
+    return nearest(sol, 1e308);
+  }
+
+  size_t elitist_archive_t::nearest(const solution_t & sol, double max_fitness) const
+  {
+    if (sols.size() == 0) {
+      return 0;
+    }
+
+    std::vector<size_t> indices;
+    vec_t distances;
+
+    tree->nearest(sol.param, 1, tree->size(), indices, distances, [this, max_fitness](size_t t)
+    {
+      return archive_index[t] != (size_t) -1 && sols[archive_index[t]]->f < max_fitness;
+    });
+
+    if (indices.size() == 0) {
+      return sols.size();
+    }
+
+    return archive_index[indices[0]];
+  }
+
+  double elitist_archive_t::best_fitness() const
+  {
+    if (sols.size() == 0 || !(sols[best_fitness_index]->f < 1e308)) {
+      return 1e308;
+    }
+
+    return sols[best_fitness_index]->f;
+  }
+
+  const solution_pt & elitist_archive_t::best_solution() const
+  {
+    assert(sols.size() > 0);
+    return sols[best_solution_index];
+  }
+
+  double elitist_archive_t::max_generation_obtained() const
+  {
+    if (sols.size() == 0 || sols[max_generation_obtained_index]->generation_obtained < 0) {
+      return 0;
+    }
+
+    return sols[max_generation_obtained_index]->generation_obtained;
+  }
+
+  // the aggregates refer to the first elite that attains them
+  void elitist_archive_t::update_aggregates(size_t i)
+  {
+    if (i == 0 || sols[i]->f < sols[best_fitness_index]->f) {
+      best_fitness_index = i;
+    }
+
+    if (i == 0 || solution_t::better_solution(*sols[i], *sols[best_solution_index])) {
+      best_solution_index = i;
+    }
+
+    if (i == 0 || sols[i]->generation_obtained > sols[max_generation_obtained_index]->generation_obtained) {
+      max_generation_obtained_index = i;
+    }
+  }
+
+  void elitist_archive_t::recompute_aggregates()
+  {
+    for (size_t i = 0; i < sols.size(); ++i) {
+      update_aggregates(i);
+    }
+  }
+
+}
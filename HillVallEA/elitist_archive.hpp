@@ -0,0 +1,75 @@
+#pragma once
+
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+*/
+
+#include "hillvallea_internal.hpp"
+#include "solution.hpp"
+#include "kdtree.hpp"
+
+namespace hillvallea
+{
+
+  // Elitist archive
+  // A list of elites with a spatial index for nearest-elite queries, and cached
+  // aggregates (best fitness, best solution, max generation_obtained) that are
+  // kept up to date on insert and replace.
+  //-------------------------------------------------------------------------------
+  class elitist_archive_t
+  {
+
+  public:
+
+    elitist_archive_t();
+    ~elitist_archive_t();
+
+    // vector-like access
+    size_t size() const;
+    const solution_pt & operator[](size_t i) const;
+    std::vector<solution_pt>::const_iterator begin() const;
+    std::vector<solution_pt>::const_iterator end() const;
+    operator const std::vector<solution_pt> & () const;
+
+    // modification
+    void clear();
+    void push_back(const solution_pt & sol);
+    void replace(size_t i, const solution_pt & sol);
+
+    // index of the elite nearest to sol, considering only elites with
+    // f < max_fitness. Returns size() if there is none.
+    size_t nearest(const solution_t & sol) const;
+    size_t nearest(const solution_t & sol, double max_fitness) const;
+
+    // cached aggregates
+    double best_fitness() const;                    // lowest f, 1e308 if empty
+    const solution_pt & best_solution() const;      // best according to solution_t::better_solution
+    double max_generation_obtained() const;         // 0 if empty
+
+  private:
+
+    void update_aggregates(size_t i);
+    void recompute_aggregates();
+
+    std::vector<solution_pt> sols;
+
+    // elites are never removed from the tree. A replaced elite is inserted again,
+    // tree_index maps each elite to its (latest) tree point, and archive_index
+    // maps tree points back to the archive (or to -1 if outdated).
+    kdtree_pt tree;
+    std::vector<size_t> tree_index;
+    std::vector<size_t> archive_index;
+
+    size_t best_fitness_index;
+    size_t best_solution_index;
+    size_t max_generation_obtained_index;
+
+  };
+
+}
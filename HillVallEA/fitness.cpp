@@ -47,6 +47,79 @@ void hillvallea::fitness_t::evaluate(solution_pt & sol)
   evaluate(*sol); 
 }
 
+void hillvallea::fitness_t::set_number_of_threads(size_t number_of_threads)
+{
+  if (number_of_threads > 1) {
+    thread_pool = std::make_shared<thread_pool_t>(number_of_threads);
+  }
+  else {
+    thread_pool = nullptr;
+  }
+}
+
+void hillvallea::fitness_t::evaluate_batch(std::vector<solution_pt> & sols, size_t begin, size_t end)
+{
+  if (end <= begin) {
+    return;
+  }
+
+  // each chunk is gathered, evaluated and written back independently,
+  // so the result does not depend on the number of threads.
+  auto evaluate_chunk = [this, &sols](size_t chunk_begin, size_t chunk_end)
+  {
+    size_t number_of_solutions = chunk_end - chunk_begin;
+
+    // gather the parameters in a contiguous block
+    vec_t params(number_of_solutions * number_of_parameters);
+    vec_t f(number_of_solutions);
+    vec_t penalty(number_of_solutions);
+
+    for (size_t i = 0; i < number_of_solutions; ++i)
+    {
+      const solution_t & sol = *sols[chunk_begin + i];
+      assert(sol.param.size() == number_of_parameters);
+
+      std::copy(sol.param.begin(), sol.param.end(), params.begin() + i * number_of_parameters);
+      penalty[i] = sol.penalty;
+    }
+
+    define_problem_evaluation_batch(params.data(), number_of_solutions, f.data(), penalty.data());
+
+    // write back the results
+    for (size_t i = 0; i < number_of_solutions; ++i)
+    {
+      sols[chunk_begin + i]->f = f[i];
+      sols[chunk_begin + i]->penalty = penalty[i];
+    }
+  };
+
+  if (thread_pool != nullptr) {
+    thread_pool->parallel_for(begin, end, evaluate_chunk);
+  }
+  else {
+    evaluate_chunk(begin, end);
+  }
+
+  number_of_evaluations += (unsigned int) (end - begin);
+}
+
+// default batch evaluation: one point at a time using define_problem_evaluation
+void hillvallea::fitness_t::define_problem_evaluation_batch(const double * params, size_t number_of_solutions, double * f, double * penalty)
+{
+  solution_t sol(number_of_parameters);
+
+  for (size_t i = 0; i < number_of_solutions; ++i)
+  {
+    std::copy(params + i * number_of_parameters, params + (i + 1) * number_of_parameters, sol.param.begin());
+    sol.penalty = penalty[i];
+
+    define_problem_evaluation(sol);
+
+    f[i] = sol.f;
+    penalty[i] = sol.penalty;
+  }
+}
+
 // evaluates the function
 // for new functions, set problem_evaluation.
 // evaluate covers the evaluation itself and can be set to cover other stuff
@@ -66,6 +139,11 @@ std::string hillvallea::fitness_t::name() const
   return "no name";
 }
 
+void hillvallea::fitness_t::get_linkage_blocks(std::vector<std::vector<size_t>> & blocks) const
+{
+  blocks.clear();
+}
+
 void hillvallea::fitness_t::init_solutions_randomly(population_pt & population, size_t sample_size, size_t number_of_elites, rng_pt rng)
 {
   std::cout << "fitness_function warning 'init_solutions_randomly' not implemented" << std::endl;
@@ -12,8 +12,10 @@ smaree.com
 
 
 #include <functional>
+#include <atomic>
 #include "hillvallea_internal.hpp"
 #include "population.hpp"
+#include "threadpool.hpp"
 
 
 // Defines the fitness function of our choice
@@ -32,11 +34,17 @@ namespace hillvallea
     ~fitness_t();
 
     size_t number_of_parameters;
-    unsigned int number_of_evaluations;
+    std::atomic<unsigned int> number_of_evaluations;
     unsigned int maximum_number_of_evaluations;
 
     size_t get_number_of_parameters() const;
 
+    // multi-threaded batch evaluation (opt-in, default is a single thread)
+    // evaluate_batch then splits each batch over the threads.
+    // define_problem_evaluation(_batch) must be thread-safe when using this.
+    void set_number_of_threads(size_t number_of_threads);
+    thread_pool_pt thread_pool;
+
     // evaluates the function
     // for new functions, define problem_evaluation in "define_problem_evaluation".
     // evaluate covers the evaluation itself and can be set to cover other stuff
@@ -44,13 +52,28 @@ namespace hillvallea
     void evaluate(solution_t & sol);
     void evaluate(solution_pt & sol);
 
+    // evaluates the solutions sols[begin] ... sols[end-1] as a single batch.
+    // the parameters are gathered in a contiguous (row-major) block, passed to
+    // define_problem_evaluation_batch, and f and penalty are written back.
+    void evaluate_batch(std::vector<solution_pt> & sols, size_t begin, size_t end);
+
     // Placeholders for user-defined objective functions
     //----------------------------------------------------------------------------------------
     virtual void set_number_of_parameters(size_t & number_of_parameters);
     virtual void get_param_bounds(vec_t & lower, vec_t & upper) const;
     virtual void define_problem_evaluation(solution_t & sol);
 
+    // evaluates number_of_solutions parameter vectors at once. params is a
+    // contiguous block of number_of_solutions x number_of_parameters doubles.
+    // the default falls back to define_problem_evaluation for each point.
+    virtual void define_problem_evaluation_batch(const double * params, size_t number_of_solutions, double * f, double * penalty);
+
     virtual std::string name() const;
+
+    // optional block partition of the parameters (a linkage model), for the
+    // block-diagonal optimizer (amalgam_block_t). Each block lists the indices of
+    // parameters that are dependent. If left empty, the optimizer learns it.
+    virtual void get_linkage_blocks(std::vector<std::vector<size_t>> & blocks) const;
     
     // redefine initialization
     bool redefine_random_initialization;
@@ -13,6 +13,8 @@ github.com/SCMaree/HillVallEA
 #include "population.hpp"
 #include "mathfunctions.hpp"
 #include "hgml.hpp"
+#include "population_soa.hpp"
+#include "distance.hpp"
 
 //---------------------------------------------------------------------
 //
@@ -57,13 +59,67 @@ hillvallea::hgml_cluster_t::~hgml_cluster_t() { }
 // Sort the population such that best = first
 //-------------------------------------------------------------------------------------
 void hillvallea::hgml_cluster_t::sort_on_fitness() {
-  std::sort(sols.begin(),sols.end(),solution_t::better_solution_via_pointers);
+  std::vector<size_t> order(sols.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+
+  std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+    return solution_t::better_solution(*sols[a], *sols[b]);
+  });
+
+  permute(order);
 }
 
 // Sort the population such that highest probability = first
 //-------------------------------------------------------------------------------------
 void hillvallea::hgml_cluster_t::sort_on_probability(){
-  std::sort(sols.begin(), sols.end(), solution_t::higher_probability);
+  std::vector<size_t> order(sols.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+
+  std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+    return probability[a] > probability[b];
+  });
+
+  permute(order);
+}
+
+void hillvallea::hgml_cluster_t::permute(const std::vector<size_t> & order)
+{
+  std::vector<solution_pt> permuted_sols(order.size());
+  for (size_t k = 0; k < order.size(); ++k) {
+    permuted_sols[k] = sols[order[k]];
+  }
+  sols.swap(permuted_sols);
+
+  if (probability.size() == order.size())
+  {
+    vec_t permuted_probability(order.size());
+    for (size_t k = 0; k < order.size(); ++k) {
+      permuted_probability[k] = probability[order[k]];
+    }
+    probability.swap(permuted_probability);
+  }
+
+  if (probability_rank.size() == order.size())
+  {
+    std::vector<int> permuted_rank(order.size());
+    for (size_t k = 0; k < order.size(); ++k) {
+      permuted_rank[k] = probability_rank[order[k]];
+    }
+    probability_rank.swap(permuted_rank);
+  }
+
+  if (fitness_rank.size() == order.size())
+  {
+    std::vector<int> permuted_rank(order.size());
+    for (size_t k = 0; k < order.size(); ++k) {
+      permuted_rank[k] = fitness_rank[order[k]];
+    }
+    fitness_rank.swap(permuted_rank);
+  }
 }
 
 
@@ -85,8 +141,8 @@ double hillvallea::hgml_cluster_t::compute_fitness_correlation()
   if (N <= 1)
     return fitness_correlation;
   
-  for (auto sol : sols) {
-    rankdifference = (double)(sol->fitness_rank - sol->probability_rank);
+  for (size_t i = 0; i < sols.size(); ++i) {
+    rankdifference = (double)(fitness_rank[i] - probability_rank[i]);
     fitness_correlation += rankdifference*rankdifference;
   }
   
@@ -104,16 +160,18 @@ double hillvallea::hgml_cluster_t::compute_fitness_correlation()
 void hillvallea::hgml_cluster_t::set_probability_rank()
 {
   
-  for (auto sol : sols) {
-    sol->probability = normpdf(mean_vector, cholesky_matrix, inverse_cholesky_matrix, sol->param);
+  probability.resize(sols.size());
+  for (size_t i = 0; i < sols.size(); ++i) {
+    probability[i] = normpdf(mean_vector, cholesky_matrix, inverse_cholesky_matrix, sols[i]->param);
   }
   
   // sort the population on probability
   sort_on_probability();
   
-  // set the fitness rank
+  // set the probability rank
+  probability_rank.resize(sols.size());
   for (size_t i = 0; i < sols.size(); ++i) {
-    sols[i]->probability_rank = (int) i;
+    probability_rank[i] = (int) i;
   }
   
 }
@@ -125,8 +183,9 @@ void hillvallea::hgml_cluster_t::set_fitness_rank(){
   sort_on_fitness();
   
   // set the fitness ranks
+  fitness_rank.resize(sols.size());
   for (size_t i = 0; i < sols.size(); ++i) {
-    sols[i]->fitness_rank = (int) i;
+    fitness_rank[i] = (int) i;
   }
 }
 
@@ -137,8 +196,7 @@ void hillvallea::hgml_cluster_t::update_cholesky()
   // apply the multiplier
   choleskyDecomposition(covariance_matrix, cholesky_matrix);
   
-  int n = (int)covariance_matrix.rows();
-  inverse_cholesky_matrix.setRaw(matrixLowerTriangularInverse(cholesky_matrix.toArray(), n),n,n);
+  matrixLowerTriangularInverse(cholesky_matrix, inverse_cholesky_matrix);
   
 }
 
@@ -261,14 +319,21 @@ void hillvallea::hgml_t::generate_nearest_better_tree(population_t & pop, std::v
   double nearest_distance = 1e308;
   double current_distance_to_j = 0.0;
   
+  // the distances from i to all j < i are computed at once on a contiguous copy of the parameters
+  population_soa_t block;
+  block.gather(pop);
+  vec_t squared_distances_to_better(kernels.size());
+
   nearest_distance = 0; //[0] is the best-so-far, it has no nearest_better
   for (size_t i = 1; i < kernels.size(); ++i)
   {
+    squared_distances(block.param(i), block.param(0), i, d, block.leading_dimension(), squared_distances_to_better.data());
+
     nearest_distance = 1e308;
     for (size_t j = 0; j < i; ++j)
     {
       // compute the distance to from i to j.
-      current_distance_to_j = sqrt(kernels[i]->weight * kernels[j]->weight) *  kernels[i]->sols[0]->param_distance(*kernels[j]->sols[0]);
+      current_distance_to_j = sqrt(kernels[i]->weight * kernels[j]->weight) * sqrt(squared_distances_to_better[j]);
       
       if (current_distance_to_j < nearest_distance)
       {
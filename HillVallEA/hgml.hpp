@@ -33,6 +33,11 @@ namespace hillvallea
     // cluster parameters
     double weight;                    // weight of the population (in clustering)
     double fitness_correlation;       // Fitness-density rank correlation
+
+    // per-solution data for the rank correlation, in line with sols
+    vec_t probability;
+    std::vector<int> fitness_rank;
+    std::vector<int> probability_rank;
     
     // Fitness-Density Correlation
     //----------------------------------------------
@@ -45,7 +50,11 @@ namespace hillvallea
     
     void update_cholesky();
     void update_cholesky_univariate();
-    
+
+  private:
+
+    // reorders sols and the per-solution data: the k-th solution becomes sols[order[k]]
+    void permute(const std::vector<size_t> & order);
     
   };
   
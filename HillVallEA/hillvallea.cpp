@@ -14,6 +14,9 @@ github.com/SCMaree/HillVallEA
 #include "mathfunctions.hpp"
 #include "fitness.h"
 #include "hgml.hpp"
+#include "threadpool.hpp"
+#include "kdtree.hpp"
+#include "solution_pool.hpp"
 
 namespace hillvallea
 {
@@ -55,8 +58,9 @@ namespace hillvallea
     this->write_generational_statistics = write_generational_statistics;
     this->write_directory = write_directory;
     this->file_appendix = file_appendix;
+    this->number_of_threads = 1;
 
-    rng = std::make_shared<std::mt19937>((unsigned long)(random_seed));
+    rng = std::make_shared<rng_t>((uint64_t)(random_seed));
     std::uniform_real_distribution<double> unif(0, 1);
 
     init_default_params();
@@ -92,8 +96,9 @@ namespace hillvallea
     this->write_generational_statistics = false;
     this->write_directory = "";
     this->file_appendix = "";
+    this->number_of_threads = 1;
 
-    rng = std::make_shared<std::mt19937>((unsigned long)(random_seed));
+    rng = std::make_shared<rng_t>((uint64_t)(random_seed));
     std::uniform_real_distribution<double> unif(0, 1);
 
     init_default_params();
@@ -199,7 +204,7 @@ namespace hillvallea
 
   }
 
-  void hillvallea_t::write_statistics_line_population(const population_t & pop, const std::vector<optimizer_pt> & local_optimizers, const std::vector<solution_pt> & elitist_archive)
+  void hillvallea_t::write_statistics_line_population(const population_t & pop, const std::vector<optimizer_pt> & local_optimizers, const elitist_archive_t & elitist_archive)
   {
     
     
@@ -208,12 +213,8 @@ namespace hillvallea
     
     solution_t best = *pop.first();
     
-    for (auto sol = elitist_archive.begin(); sol != elitist_archive.end(); ++sol)
-    {
-      if (solution_t::better_solution(**sol, best))
-      {
-        best = **sol;
-      }
+    if (elitist_archive.size() > 0 && solution_t::better_solution(*elitist_archive.best_solution(), best)) {
+      best = *elitist_archive.best_solution();
     }
     
     statistics_file
@@ -229,7 +230,7 @@ namespace hillvallea
       << std::endl;
   }
   
-  void hillvallea_t::write_statistics_line_cluster(const population_t & cluster_pop, int cluster_number, int cluster_generation, const std::vector<optimizer_pt> & local_optimizers, const std::vector<solution_pt> & elitist_archive)
+  void hillvallea_t::write_statistics_line_cluster(const population_t & cluster_pop, int cluster_number, int cluster_generation, const std::vector<optimizer_pt> & local_optimizers, const elitist_archive_t & elitist_archive)
   {
     
     
@@ -238,12 +239,8 @@ namespace hillvallea
     
     solution_t best = *cluster_pop.first();
     
-    for (auto sol = elitist_archive.begin(); sol != elitist_archive.end(); ++sol)
-    {
-      if (solution_t::better_solution(**sol, best))
-      {
-        best = **sol;
-      }
+    if (elitist_archive.size() > 0 && solution_t::better_solution(*elitist_archive.best_solution(), best)) {
+      best = *elitist_archive.best_solution();
     }
     
     statistics_file
@@ -324,7 +321,7 @@ namespace hillvallea
 
   }
   
-  void hillvallea_t::write_elitist_archive_file(const std::vector<solution_pt> & elitist_archive, bool final) const
+  void hillvallea_t::write_elitist_archive_file(const elitist_archive_t & elitist_archive, bool final) const
   {
     std::ofstream file;
     std::string filename;
@@ -420,27 +417,17 @@ namespace hillvallea
     // double TargetTolFun = 1e-5;
     if (elitist_archive.size() > 0)
     {
-      // find the nearest elite
-      for (size_t j = 0; j < elitist_archive.size(); ++j)
-      {
+      // find the nearest elite, only considering elites that have better fitness
+      size_t j = elitist_archive.nearest(*local_optimizer.pop->sols[0], local_optimizer.pop->sols[0]->f + TargetTolFun);
 
-        // only consider elites that have better fitness
-        if (elitist_archive[j]->f < (local_optimizer.pop->sols[0]->f + TargetTolFun))
-        {
-
-          distance = elitist_archive[j]->param_distance(*local_optimizer.pop->sols[0]);
-          if (distance < distance_to_nearest_elite)
-          {
-            distance_to_nearest_elite = distance;
-            nearest_elite = elitist_archive[j];
-          }
-
-          // also find the best elite in the archive for later
-          if (elitist_archive[j]->f < best_fitness_so_far) {
-            best_fitness_so_far = elitist_archive[j]->f;
-          }
-        }
+      if (j < elitist_archive.size()) {
+        distance_to_nearest_elite = elitist_archive[j]->param_distance(*local_optimizer.pop->sols[0]);
+        nearest_elite = elitist_archive[j];
+      }
 
+      // also find the best elite in the archive for later
+      if (elitist_archive.best_fitness() < best_fitness_so_far) {
+        best_fitness_so_far = elitist_archive.best_fitness();
       }
     }
 
@@ -481,14 +468,9 @@ namespace hillvallea
     double best = 1e308;
     double max_number_of_generations_to_obtain_elite = 0;
 
-    for (size_t i = 0; i < elitist_archive.size(); ++i) {
-      if (elitist_archive[i]->f < best) {
-        best = elitist_archive[i]->f;
-      }
-
-      if (elitist_archive[i]->generation_obtained > max_number_of_generations_to_obtain_elite) {
-        max_number_of_generations_to_obtain_elite = elitist_archive[i]->generation_obtained;
-      }
+    if (elitist_archive.size() > 0) {
+      best = elitist_archive.best_fitness();
+      max_number_of_generations_to_obtain_elite = elitist_archive.max_generation_obtained();
     }
 
     for (size_t i = 0; i < elite_candidates.size(); ++i) {
@@ -554,7 +536,9 @@ namespace hillvallea
 
   //----------------------------------------------------------------------------------------------
   // samples an initial population uniformly random, clusters it into a set of local_optimizers
-  void hillvallea_t::initialize(population_pt pop, size_t population_size, double selection_fraction_multiplier, std::vector<optimizer_pt> & local_optimizers, const std::vector<solution_pt> & elitist_archive)
+  // All random numbers of a restart are drawn from substreams of restart_rng: 0 for the
+  // initial population, 1 for the dummy optimizer and 2 + c for the optimizer of cluster c.
+  void hillvallea_t::initialize(population_pt pop, size_t population_size, double selection_fraction_multiplier, std::vector<optimizer_pt> & local_optimizers, const elitist_archive_t & elitist_archive, const rng_t & restart_rng)
   {
 
     // Initialize running parameters of hillvallea
@@ -570,7 +554,7 @@ namespace hillvallea
     double sample_ratio = 2.0;
     // pop->fill_greedy_uniform(population_size, number_of_parameters, sample_ratio, lower_init_ranges, upper_init_ranges, rng);
     
-    pop->fill_with_rejection(population_size, number_of_parameters, sample_ratio, backup_sols, lower_init_ranges, upper_init_ranges, rng);
+    pop->fill_with_rejection(population_size, number_of_parameters, sample_ratio, backup_sols, lower_init_ranges, upper_init_ranges, std::make_shared<rng_t>(restart_rng.stream(0)), thread_pool);
     
     {
       int fevals = pop->evaluate(this->fitness_function, 0); // no elite yet.
@@ -582,7 +566,7 @@ namespace hillvallea
 
     // create a dummy local_optimizer for the initial population so that we can perform selection and we can write it down.
     double init_univariate_bandwidth = scaled_search_volume * pow(pop->size(), -1.0/number_of_parameters);
-    optimizer_pt local_optimizer = init_optimizer(local_optimizer_index, number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, rng);
+    optimizer_pt local_optimizer = init_optimizer(local_optimizer_index, number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, std::make_shared<rng_t>(restart_rng.stream(1)));
     local_optimizer->initialize_from_population(pop);
 
     population_pt selection = std::make_shared<population_t>();
@@ -627,7 +611,11 @@ namespace hillvallea
     {
       if ((*cluster)->sols.size() > 0)
       {
-        optimizer_pt opt = init_optimizer(local_optimizer_index, number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, rng);
+        // each local optimizer has its own stream, whether they run concurrently or not
+        rng_pt opt_rng = std::make_shared<rng_t>(restart_rng.stream(2 + local_optimizers.size()));
+
+        optimizer_pt opt = init_optimizer(local_optimizer_index, number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, opt_rng);
+        (*cluster)->solution_pool = solution_pool;
         opt->initialize_from_population(*cluster);
         opt->average_fitness_history.push_back(opt->pop->average_fitness());
         local_optimizers.push_back(opt);
@@ -688,7 +676,8 @@ namespace hillvallea
     number_of_evaluations_init = 0;
     number_of_evaluations_clustering = 0;
     number_of_generations = 0;
-    bool restart = true;
+    std::atomic<bool> restart(true);
+    size_t number_of_restarts = 0;
     int number_of_generations_without_new_clusters = 0;
     elitist_archive.clear();
 
@@ -711,6 +700,22 @@ namespace hillvallea
     if(write_generational_statistics) {
       new_statistics_file();
     }
+
+    // the pool is created once and used for the whole run. Unless the fitness
+    // function has a pool of its own, its evaluations are scheduled on it as well.
+    bool shared_evaluation_pool = false;
+    if (number_of_threads > 1)
+    {
+      thread_pool = std::make_shared<thread_pool_t>(number_of_threads);
+
+      if (fitness_function->thread_pool == nullptr) {
+        fitness_function->thread_pool = thread_pool;
+        shared_evaluation_pool = true;
+      }
+    }
+    else {
+      thread_pool = nullptr;
+    }
     
     // The big restart scheme
     //--------------------------------------------
@@ -747,8 +752,13 @@ namespace hillvallea
         }
       }
       
+      // solutions sampled during this restart are taken from a fresh pool
+      solution_pool = std::make_shared<solution_pool_t>();
+      pop->solution_pool = solution_pool;
+
       // compute initial population
-      initialize(pop, (size_t) current_population_size, current_selection_fraction_multiplier, local_optimizers, elitist_archive);
+      initialize(pop, (size_t) current_population_size, current_selection_fraction_multiplier, local_optimizers, elitist_archive, rng->stream(number_of_restarts));
+      number_of_restarts++;
       
       // we only create local optimizers from the global opts
       // so the local optimizer still inits new global opts
@@ -773,92 +783,19 @@ namespace hillvallea
       }
 
       // Run each of the local optimizers until convergence
-      for (size_t i = 0; i < local_optimizers.size(); ++i)
+      if (thread_pool != nullptr)
       {
-
-        // current local optimizer
-        while (true)
+        thread_pool->parallel_for(0, local_optimizers.size(), [&](size_t begin, size_t end)
         {
-
-          // stop if the feval budget is reached
-          size_t fevals_needed_to_check_elites = 1 + (size_t)(elite_candidates.size() * add_elites_max_trials * (elitist_archive.size() + elite_candidates.size() * 0.5));
-
-          if (maximum_number_of_evaluations > 0 && number_of_evaluations + fevals_needed_to_check_elites + current_cluster_size >= maximum_number_of_evaluations) {
-            restart = false;
-            if (local_optimizers[i]->pop->size() > 0) {
-              elite_candidates.push_back(local_optimizers[i]->pop->sols[0]);
-            }
-            break;
-          }
-
-          // stop if we run out of time.
-          if (terminate_on_runtime()) {
-            restart = false;
-            if (local_optimizers[i]->pop->size() > 0) {
-              elite_candidates.push_back(local_optimizers[i]->pop->sols[0]);
-            }
-            break;
-          }
-
-          // stop if the vtr is hit
-          if (use_vtr && local_optimizers[i]->pop->sols[0]->f < vtr)
-          {
-            restart = false;
-            best = *local_optimizers[i]->pop->sols[0];
-            success = true;
-            break;
-          }
-
-          // stop this local optimizer if it approaches a previously obtained elite (candidate) 
-          if ((1 + local_optimizers[i]->number_of_generations) % 5 == 0)
-          {
-            if (terminate_on_approaching_elite(*local_optimizers[i], elite_candidates)) {
-              local_optimizers[i]->active = false;
-              break;
-            }
-          }
-
-          // stop this local optimizer if it converges to a local optimum
-          if (terminate_on_converging_to_local_optimum(*local_optimizers[i], elite_candidates)) {
-            local_optimizers[i]->active = false;
-            break;
-          }
-
-          // if the cluster is active, and after checking it, it is terminated, 
-          // we add the best solution to the elitist archive
-          if (local_optimizers[i]->active && local_optimizers[i]->checkTerminationCondition()) 
-          {
-            if (local_optimizers[i]->pop->size() > 0)
-            {
-              if (elitist_archive.size() == 0 || local_optimizers[i]->pop->sols[0]->f < elitist_archive[0]->f + TargetTolFun) {
-                elite_candidates.push_back(local_optimizers[i]->pop->sols[0]);
-                elite_candidates.back()->generation_obtained = local_optimizers[i]->number_of_generations;
-              }
-              
-              break;
-            }
-          }
-
-          // if it is still active, run a generation of the local optimizer
-          if (local_optimizers[i]->active)
-          {
-
-            local_optimizers[i]->estimate_sample_parameters();
-
-            int local_number_of_evaluations = (int)local_optimizers[i]->sample_new_population((size_t) current_cluster_size);
-            number_of_evaluations += local_number_of_evaluations;
-
-            if (write_generational_solutions) {
-              write_cluster_population(number_of_generations, i, local_optimizers[i]->number_of_generations, local_optimizers[i]->pop);
-            }
-
-            local_optimizers[i]->pop->truncation_percentage(*local_optimizers[i]->pop, local_optimizers[i]->selection_fraction);
-            local_optimizers[i]->average_fitness_history.push_back(local_optimizers[i]->pop->average_fitness());
-
-            if (write_generational_statistics) {
-              write_statistics_line_cluster(*local_optimizers[i]->pop, (int) i, local_optimizers[i]->number_of_generations, local_optimizers, elitist_archive);
-            }
+          for (size_t i = begin; i < end; ++i) {
+            run_local_optimizer(i, local_optimizers, elite_candidates, current_cluster_size, restart);
           }
+        }, 1); // cluster lifetimes are very uneven, so schedule them one by one
+      }
+      else
+      {
+        for (size_t i = 0; i < local_optimizers.size(); ++i) {
+          run_local_optimizer(i, local_optimizers, elite_candidates, current_cluster_size, restart);
         }
       }
 
@@ -907,24 +844,128 @@ namespace hillvallea
       close_statistics_file();
     }
 
+    if (shared_evaluation_pool) {
+      fitness_function->thread_pool = nullptr;
+    }
+    thread_pool = nullptr;
+    solution_pool = nullptr;
 
   }
 
 
-  void hillvallea_t::add_elites_to_archive(std::vector<solution_pt> & elitist_archive, const std::vector<solution_pt> & elite_candidates, int & number_of_global_opts_found, int & number_of_new_global_opts_found)
+  // runs local optimizer i until it terminates.
+  // elite_candidates is shared between concurrently running local optimizers,
+  // so it is only accessed under elite_candidates_mutex.
+  void hillvallea_t::run_local_optimizer(size_t i, std::vector<optimizer_pt> & local_optimizers, std::vector<solution_pt> & elite_candidates, double current_cluster_size, std::atomic<bool> & restart)
+  {
+    optimizer_pt local_optimizer = local_optimizers[i];
+
+    while (true)
+    {
+
+      // the elite candidates found so far
+      std::vector<solution_pt> current_elite_candidates;
+      {
+        std::lock_guard<std::mutex> lock(elite_candidates_mutex);
+        current_elite_candidates = elite_candidates;
+      }
+
+      // stop if the feval budget is reached
+      size_t fevals_needed_to_check_elites = 1 + (size_t)(current_elite_candidates.size() * add_elites_max_trials * (elitist_archive.size() + current_elite_candidates.size() * 0.5));
+
+      if (maximum_number_of_evaluations > 0 && number_of_evaluations + fevals_needed_to_check_elites + current_cluster_size >= maximum_number_of_evaluations) {
+        restart = false;
+        if (local_optimizer->pop->size() > 0) {
+          std::lock_guard<std::mutex> lock(elite_candidates_mutex);
+          elite_candidates.push_back(local_optimizer->pop->sols[0]);
+        }
+        break;
+      }
+
+      // stop if we run out of time.
+      if (terminate_on_runtime()) {
+        restart = false;
+        if (local_optimizer->pop->size() > 0) {
+          std::lock_guard<std::mutex> lock(elite_candidates_mutex);
+          elite_candidates.push_back(local_optimizer->pop->sols[0]);
+        }
+        break;
+      }
+
+      // stop if the vtr is hit
+      if (use_vtr && local_optimizer->pop->sols[0]->f < vtr)
+      {
+        restart = false;
+        std::lock_guard<std::mutex> lock(elite_candidates_mutex);
+        best = *local_optimizer->pop->sols[0];
+        success = true;
+        break;
+      }
+
+      // stop this local optimizer if it approaches a previously obtained elite (candidate) 
+      if ((1 + local_optimizer->number_of_generations) % 5 == 0)
+      {
+        if (terminate_on_approaching_elite(*local_optimizer, current_elite_candidates)) {
+          local_optimizer->active = false;
+          break;
+        }
+      }
+
+      // stop this local optimizer if it converges to a local optimum
+      if (terminate_on_converging_to_local_optimum(*local_optimizer, current_elite_candidates)) {
+        local_optimizer->active = false;
+        break;
+      }
+
+      // if the cluster is active, and after checking it, it is terminated, 
+      // we add the best solution to the elitist archive
+      if (local_optimizer->active && local_optimizer->checkTerminationCondition()) 
+      {
+        if (local_optimizer->pop->size() > 0)
+        {
+          if (elitist_archive.size() == 0 || local_optimizer->pop->sols[0]->f < elitist_archive[0]->f + TargetTolFun) {
+            std::lock_guard<std::mutex> lock(elite_candidates_mutex);
+            elite_candidates.push_back(local_optimizer->pop->sols[0]);
+            elite_candidates.back()->generation_obtained = local_optimizer->number_of_generations;
+          }
+          
+          break;
+        }
+      }
+
+      // if it is still active, run a generation of the local optimizer
+      if (local_optimizer->active)
+      {
+
+        local_optimizer->estimate_sample_parameters();
+
+        int local_number_of_evaluations = (int)local_optimizer->sample_new_population((size_t) current_cluster_size);
+        number_of_evaluations += local_number_of_evaluations;
+
+        if (write_generational_solutions) {
+          write_cluster_population(number_of_generations, i, local_optimizer->number_of_generations, local_optimizer->pop);
+        }
+
+        local_optimizer->pop->truncation_percentage(*local_optimizer->pop, local_optimizer->selection_fraction);
+        local_optimizer->average_fitness_history.push_back(local_optimizer->pop->average_fitness());
+
+        if (write_generational_statistics) {
+          std::lock_guard<std::mutex> lock(statistics_file_mutex);
+          write_statistics_line_cluster(*local_optimizer->pop, (int) i, local_optimizer->number_of_generations, local_optimizers, elitist_archive);
+        }
+      }
+    }
+  }
+
+
+  void hillvallea_t::add_elites_to_archive(elitist_archive_t & elitist_archive, const std::vector<solution_pt> & elite_candidates, int & number_of_global_opts_found, int & number_of_new_global_opts_found)
   {
 
     number_of_global_opts_found = 0;
     number_of_new_global_opts_found = 0;
 
     // find best solution in the archive
-    double best_archive = 1e308;
-    for (size_t i = 0; i < elitist_archive.size(); ++i)
-    {
-      if (elitist_archive[i]->f < best_archive) {
-        best_archive = elitist_archive[i]->f;
-      }
-    }
+    double best_archive = elitist_archive.best_fitness();
 
     // find best candidate
     double best_candidate = 1e308;
@@ -951,6 +992,23 @@ namespace hillvallea
       }
     }
 
+    // with parallel evaluations, the edges of all candidates to their nearest elite
+    // are tested up front as a single batched set of edges. If an earlier candidate
+    // changed the nearest elite of a candidate, that candidate is tested again below.
+    std::vector<hillvalley_edge_t> batched_edges;
+    std::vector<solution_pt> batched_elite(potential_candidates.size());
+
+    if (fitness_function->thread_pool != nullptr && elitist_archive.size() > 0)
+    {
+      for (size_t i = 0; i < potential_candidates.size(); ++i)
+      {
+        batched_elite[i] = elitist_archive[elitist_archive.nearest(*potential_candidates[i])];
+        batched_edges.push_back(hillvalley_edge_t(*batched_elite[i], *potential_candidates[i], add_elites_max_trials));
+      }
+
+      check_edges(batched_edges);
+    }
+
     // for each candidate, check if it is a novel local optimum
     for (size_t i = 0; i < potential_candidates.size(); ++i)
     {
@@ -960,37 +1018,30 @@ namespace hillvallea
       
       if (elitist_archive.size() > 0)
       {
-        size_t nearest_elite = 0;
-        double nearest_dist = 1e300;
-        double current_dist = 0;
-        
-        for (size_t j = 0; j < elitist_archive.size(); ++j)
-        {
+        size_t j = elitist_archive.nearest(*potential_candidates[i]);
 
-          current_dist = elitist_archive[j]->param_distance(*potential_candidates[i]);
-          
-          if(current_dist < nearest_dist)
-          {
-            nearest_dist = current_dist;
-            nearest_elite = j;
-          }
+        bool same_basin;
+        if (batched_elite[i] == elitist_archive[j]) {
+          same_basin = batched_edges[i].valid;
         }
-      
-        size_t j = nearest_elite; // lazy : re-using code..
-      
+        else {
+          same_basin = check_edge(*elitist_archive[j], *potential_candidates[i], add_elites_max_trials);
+        }
+
         // a valid edge (check_edge returns true) suggest that the two optima are the same.
-        if (check_edge(*elitist_archive[j], *potential_candidates[i], add_elites_max_trials))
+        if (same_basin)
         {
           novel = false;
           number_of_global_opts_found++;
 
           // replace the elite with the candidate if it is better
           if (solution_t::better_solution_via_pointers(potential_candidates[i], elitist_archive[j])) {
-            elitist_archive[j] = std::make_shared<solution_t>(*potential_candidates[i]);
-            elitist_archive[j]->elite = true;
-            elitist_archive[j]->time_obtained = ((double) (clock() - starting_time)) / CLOCKS_PER_SEC * 1000.0;
-            elitist_archive[j]->feval_obtained = number_of_evaluations;
-            elitist_archive[j]->generation_obtained = potential_candidates[i]->generation_obtained;
+            solution_pt elite = std::make_shared<solution_t>(*potential_candidates[i]);
+            elite->elite = true;
+            elite->time_obtained = ((double) (clock() - starting_time)) / CLOCKS_PER_SEC * 1000.0;
+            elite->feval_obtained = number_of_evaluations;
+            elite->generation_obtained = potential_candidates[i]->generation_obtained;
+            elitist_archive.replace(j, elite);
           }
 
           // break;
@@ -999,11 +1050,12 @@ namespace hillvallea
 
       // it is novel, add it to the archive
       if (novel) {
-        elitist_archive.push_back(std::make_shared<solution_t>(*potential_candidates[i]));
-        elitist_archive.back()->elite = true;
-        elitist_archive.back()->time_obtained = ((double)(clock() - starting_time)) / CLOCKS_PER_SEC * 1000.0;
-        elitist_archive.back()->feval_obtained = number_of_evaluations;
-        elitist_archive.back()->generation_obtained = potential_candidates[i]->generation_obtained;
+        solution_pt elite = std::make_shared<solution_t>(*potential_candidates[i]);
+        elite->elite = true;
+        elite->time_obtained = ((double)(clock() - starting_time)) / CLOCKS_PER_SEC * 1000.0;
+        elite->feval_obtained = number_of_evaluations;
+        elite->generation_obtained = potential_candidates[i]->generation_obtained;
+        elitist_archive.push_back(elite);
         number_of_new_global_opts_found++;
       }
 
@@ -1024,50 +1076,106 @@ bool hillvallea::hillvallea_t::check_edge(const hillvallea::solution_t &sol1, co
 
 bool hillvallea::hillvallea_t::check_edge(const hillvallea::solution_t &sol1, const hillvallea::solution_t &sol2, int max_trials, std::vector<solution_pt> & test_points)
 {
+  std::vector<hillvalley_edge_t> edges(1, hillvalley_edge_t(sol1, sol2, max_trials));
+  check_edges(edges);
 
-  if (sol1.param_distance(sol2) == 0) {
-    return true;
-  }
-  
-  // elites are already checked to be in different basins
-  if (sol1.elite && sol2.elite) {
-    return false;
-  }
+  test_points.insert(test_points.end(), edges[0].test_points.begin(), edges[0].test_points.end());
 
-  // check max_trials with number_of_evaluations remaining
-  if (maximum_number_of_evaluations > 0 && max_trials > maximum_number_of_evaluations - number_of_evaluations) {
-    max_trials = maximum_number_of_evaluations - number_of_evaluations;
-  }
+  return edges[0].valid;
+}
 
-  // find the worst solution of the two. 
-  solution_t worst;
-  if (solution_t::better_solution(sol1, sol2)) {
-    worst = sol2;
-  }
-  else {
-    worst = sol1;
+hillvallea::hillvalley_edge_t::hillvalley_edge_t(const hillvallea::solution_t &sol1, const hillvallea::solution_t &sol2, int max_trials)
+{
+  this->sol1 = &sol1;
+  this->sol2 = &sol2;
+  this->max_trials = max_trials;
+  this->valid = true;
+}
+
+hillvallea::hillvalley_edge_t::~hillvalley_edge_t() {}
+
+void hillvallea::hillvallea_t::check_edges(std::vector<hillvalley_edge_t> & edges)
+{
+
+  // the edges that are still undecided, and the worst solution of their two end points
+  std::vector<size_t> undecided;
+  std::vector<const solution_t *> worst(edges.size(), nullptr);
+
+  for (size_t i = 0; i < edges.size(); ++i)
+  {
+    hillvalley_edge_t & edge = edges[i];
+    edge.valid = true;
+
+    if (edge.sol1->param_distance(*edge.sol2) == 0) {
+      continue;
+    }
+
+    // elites are already checked to be in different basins
+    if (edge.sol1->elite && edge.sol2->elite) {
+      edge.valid = false;
+      continue;
+    }
+
+    // check max_trials with number_of_evaluations remaining
+    if (maximum_number_of_evaluations > 0 && edge.max_trials > maximum_number_of_evaluations - number_of_evaluations) {
+      edge.max_trials = maximum_number_of_evaluations - number_of_evaluations;
+    }
+
+    // find the worst solution of the two. 
+    if (solution_t::better_solution(*edge.sol1, *edge.sol2)) {
+      worst[i] = edge.sol2;
+    }
+    else {
+      worst[i] = edge.sol1;
+    }
+
+    if (edge.max_trials > 0) {
+      undecided.push_back(i);
+    }
   }
 
-  for (size_t k = 0; k < max_trials; k++)
+  for (size_t k = 0; undecided.size() > 0; k++)
   {
 
-    solution_pt x_test = std::make_shared<solution_t>(sol1.param.size());
+    // edges that do not fit in the remaining budget are not tested any further
+    if (maximum_number_of_evaluations > 0 && (int) undecided.size() > maximum_number_of_evaluations - number_of_evaluations) {
+      undecided.resize(std::max(0, maximum_number_of_evaluations - number_of_evaluations));
+    }
 
-    x_test->param = sol1.param + ((k + 1.0) / (max_trials + 1.0)) * (sol2.param - sol1.param);
+    // the k-th interior point of each undecided edge
+    std::vector<solution_pt> round_test_points(undecided.size());
 
-    fitness_function->evaluate(x_test);
-    number_of_evaluations++;
-    number_of_evaluations_clustering++;
+    for (size_t i = 0; i < undecided.size(); ++i)
+    {
+      hillvalley_edge_t & edge = edges[undecided[i]];
 
-    test_points.push_back(x_test);
+      solution_pt x_test = (solution_pool != nullptr) ? solution_pool->make_solution(edge.sol1->param.size()) : std::make_shared<solution_t>(edge.sol1->param.size());
+      x_test->param = edge.sol1->param + ((k + 1.0) / (edge.max_trials + 1.0)) * (edge.sol2->param - edge.sol1->param);
+
+      edge.test_points.push_back(x_test);
+      round_test_points[i] = x_test;
+    }
+
+    fitness_function->evaluate_batch(round_test_points, 0, round_test_points.size());
+    number_of_evaluations += (int) round_test_points.size();
+    number_of_evaluations_clustering += (int) round_test_points.size();
 
     // if f[i] is better than f_test, we don't like the connection. So we stop.
-    if (solution_t::better_solution(worst, *x_test)) {
-      return false;
+    std::vector<size_t> still_undecided;
+    for (size_t i = 0; i < undecided.size(); ++i)
+    {
+      hillvalley_edge_t & edge = edges[undecided[i]];
+
+      if (solution_t::better_solution(*worst[undecided[i]], *round_test_points[i])) {
+        edge.valid = false;
+      }
+      else if (k + 1 < (size_t) edge.max_trials) {
+        still_undecided.push_back(undecided[i]);
+      }
     }
-  }
 
-  return true;
+    undecided = still_undecided;
+  }
 
 }
 
@@ -1093,48 +1201,80 @@ void hillvallea::hillvallea_t::hillvalley_clustering(population_t & pop, std::ve
   std::vector<solution_pt> test_points;
   std::vector<size_t> cluster_index_of_test_points;
   double average_edge_length = scaled_search_volume * pow(pop.size(), -1.0/number_of_parameters);
-  double* dist = (double *)Malloc((long)pop.size() * sizeof(double));
 
-  for (size_t i = 1; i < pop.size(); i++)
+  // find the nearest better neighbours of each solution up front, as they do not
+  // depend on the outcome of the edge tests. Each distinct distance is represented by
+  // its lowest index, and if there are fewer distinct distances than neighbours,
+  // the farthest one is repeated.
+  // The kd-tree is built in fitness order, so that querying the i-th solution
+  // only finds the better solutions 0, ..., i-1.
+  std::vector<std::vector<size_t>> nearest_better(pop.size());
+  std::vector<vec_t> nearest_better_dist(pop.size());
+
+  kdtree_t tree(number_of_parameters);
+  for (size_t i = 0; i < pop.size(); ++i) {
+    tree.insert(pop.sols[i]->param);
+  }
+
+  auto find_nearest_better = [&](size_t begin, size_t end)
   {
+    for (size_t i = begin; i < end; ++i)
+    {
+      size_t number_of_neighbours = std::min(i, clustering_max_number_of_neighbours);
+      std::vector<size_t> & neighbours = nearest_better[i];
+      vec_t & neighbour_dist = nearest_better_dist[i];
 
-    // compute the distance to all better solutions. 
-    dist[i] = 0.0;
-    size_t nearest_better_index = 0, worst_better_index = 0;
-    for (size_t j = 0; j < i; j++) {
-      dist[j] = pop.sols[i]->param_distance(*pop.sols[j]);
+      tree.nearest(pop.sols[i]->param, number_of_neighbours, i, neighbours, neighbour_dist);
 
-      if (dist[j] < dist[nearest_better_index]) {
-        nearest_better_index = j;
+      while (neighbours.size() > 0 && neighbours.size() < number_of_neighbours) {
+        neighbours.push_back(neighbours.back());
+        neighbour_dist.push_back(neighbour_dist.back());
       }
+    }
+  };
 
-      if (dist[j] > dist[worst_better_index]) {
-        worst_better_index = j;
-      }
+  if (thread_pool != nullptr) {
+    thread_pool->parallel_for(1, pop.size(), find_nearest_better);
+  }
+  else {
+    find_nearest_better(1, pop.size());
+  }
+
+  // the edge to the nearest better solution is always tested (unless it is force-accepted),
+  // so all of these are tested up front as a single batched set of edges.
+  std::vector<hillvalley_edge_t> first_edges;
+  std::vector<size_t> first_edge_index(pop.size(), -1);
+
+  for (size_t i = 1; i < pop.size(); i++)
+  {
+    if (nearest_better[i].size() == 0) {
+      continue;
+    }
+
+    int max_number_of_trial_solutions = 1 + ((int)(nearest_better_dist[i][0] / average_edge_length));
+
+    if (i > 0.5 * pop.size() && max_number_of_trial_solutions == 1) {
+      continue;
     }
 
+    first_edge_index[i] = first_edges.size();
+    first_edges.push_back(hillvalley_edge_t(*pop.sols[i], *pop.sols[nearest_better[i][0]], max_number_of_trial_solutions));
+  }
+
+  check_edges(first_edges);
+
+  for (size_t i = 1; i < pop.size(); i++)
+  {
+
     // Check neighbours
     bool edge_added = false;
     std::vector<size_t> does_not_belong_to(clustering_max_number_of_neighbours, -1);
-    size_t old_nearest_better_index;
     std::vector<solution_pt> new_test_points_for_this_sol;
 
-    for (size_t j = 0; j < std::min(i, clustering_max_number_of_neighbours); j++)
+    for (size_t j = 0; j < nearest_better[i].size(); j++)
     {
 
-      // find the next-to nearest index
-      if (j > 0) 
-      {
-        old_nearest_better_index = nearest_better_index;
-        nearest_better_index = worst_better_index;
-
-        for (size_t k = 0; k < i; k++) {
-
-          if (dist[k] > dist[old_nearest_better_index] && dist[k] < dist[nearest_better_index]) {
-            nearest_better_index = k;
-          }
-        }
-      }
+      size_t nearest_better_index = nearest_better[i][j];
 
       bool skip_neighbour = false;
       for (size_t k = 0; k < does_not_belong_to.size(); ++k)
@@ -1150,7 +1290,7 @@ void hillvallea::hillvallea_t::hillvalley_clustering(population_t & pop, std::ve
         continue;
       }
 
-      int max_number_of_trial_solutions = 1 + ((int)(dist[nearest_better_index] / average_edge_length));
+      int max_number_of_trial_solutions = 1 + ((int)(nearest_better_dist[i][j] / average_edge_length));
       std::vector<solution_pt> new_test_points;
       bool force_accept = false;
       
@@ -1158,7 +1298,20 @@ void hillvallea::hillvallea_t::hillvalley_clustering(population_t & pop, std::ve
         force_accept = true;
       }
       
-      if (force_accept || check_edge(*pop.sols[i], *pop.sols[nearest_better_index], max_number_of_trial_solutions, new_test_points))
+      bool edge_valid;
+
+      if (force_accept) {
+        edge_valid = true;
+      }
+      else if (j == 0) {
+        edge_valid = first_edges[first_edge_index[i]].valid;
+        new_test_points = first_edges[first_edge_index[i]].test_points;
+      }
+      else {
+        edge_valid = check_edge(*pop.sols[i], *pop.sols[nearest_better_index], max_number_of_trial_solutions, new_test_points);
+      }
+
+      if (edge_valid)
       {
         cluster_index[i] = cluster_index[nearest_better_index];
         edge_added = true;
@@ -12,9 +12,32 @@ github.com/SCMaree/HillVallEA
 
 #include "hillvallea_internal.hpp"
 #include "optimizer.hpp"
+#include "elitist_archive.hpp"
+#include <atomic>
+#include <mutex>
 
 namespace hillvallea
 {
+
+  // an edge for the Hill-Valley test, and its outcome
+  class hillvalley_edge_t {
+
+  public:
+
+    hillvalley_edge_t(const solution_t & sol1, const solution_t & sol2, int max_trials);
+    ~hillvalley_edge_t();
+
+    const solution_t * sol1;
+    const solution_t * sol2;
+    int max_trials;
+
+    // true if sol1 and sol2 belong to the same basin
+    bool valid;
+
+    // the evaluated interior points, in order
+    std::vector<solution_pt> test_points;
+
+  };
   
   class hillvallea_t
   {
@@ -71,12 +94,12 @@ namespace hillvallea
     // data members : optimization results
     //--------------------------------------------------------------------------------
     solution_t best;
-    std::vector<solution_pt> elitist_archive;
+    elitist_archive_t elitist_archive;
     bool terminated;
     bool success;
-    int number_of_evaluations;
+    std::atomic<int> number_of_evaluations;
     int number_of_evaluations_init;
-    int number_of_evaluations_clustering;
+    std::atomic<int> number_of_evaluations_clustering;
     int number_of_generations;
     double selection_fraction_multiplier;
     clock_t starting_time;
@@ -93,16 +116,26 @@ namespace hillvallea
     double TargetTolFun;
     int add_elites_max_trials;
 
+    // Parallelism (opt-in)
+    // with number_of_threads > 1, the local optimizers of a restart run concurrently,
+    // each with its own random number generator. The fitness function must be thread-safe.
+    //-------------------------------------------------------------------------------
+    size_t number_of_threads;
+
     // Hill-Valley Test and Clustering
     //--------------------------------------------------------------------------------
     void hillvalley_clustering(population_t & pop, std::vector<population_pt> & clusters);
     bool check_edge(const solution_t & sol1, const solution_t & sol2, int max_trials);
     bool check_edge(const solution_t & sol1, const solution_t & sol2, int max_trials, std::vector<solution_pt> & test_points);
 
+    // tests a set of edges in rounds. Round k evaluates the k-th interior point
+    // of all edges that are still undecided as a single batch.
+    void check_edges(std::vector<hillvalley_edge_t> & edges);
+
     // Random number generator
     // Mersenne twister
     //------------------------------------
-    std::shared_ptr<std::mt19937> rng;
+    rng_pt rng;
     bool write_elitist_archive;
 
     
@@ -129,8 +162,9 @@ namespace hillvallea
 
     // Run-time functions
     //-------------------------------------------------------------------------------
-    void initialize(population_pt pop, size_t population_size, double selection_fraction_multiplier, std::vector<optimizer_pt> & local_optimizers, const std::vector<solution_pt> & elitist_archive);
-    void add_elites_to_archive(std::vector<solution_pt> & elitist_archive, const std::vector<solution_pt> & elite_candidates, int & global_opts_found, int & new_global_opts_found);
+    void initialize(population_pt pop, size_t population_size, double selection_fraction_multiplier, std::vector<optimizer_pt> & local_optimizers, const elitist_archive_t & elitist_archive, const rng_t & restart_rng);
+    void run_local_optimizer(size_t i, std::vector<optimizer_pt> & local_optimizers, std::vector<solution_pt> & elite_candidates, double current_cluster_size, std::atomic<bool> & restart);
+    void add_elites_to_archive(elitist_archive_t & elitist_archive, const std::vector<solution_pt> & elite_candidates, int & global_opts_found, int & new_global_opts_found);
     
     // Termination criteria
     //-------------------------------------------------------------------------------
@@ -141,18 +175,25 @@ namespace hillvallea
     // data members : populations
     //--------------------------------------------------------------------------------
     population_pt pop;
+    solution_pool_pt solution_pool; // renewed every restart, frees that restart's solutions in bulk
+
+    // data members : parallelism
+    //--------------------------------------------------------------------------------
+    thread_pool_pt thread_pool;
+    std::mutex elite_candidates_mutex;
+    std::mutex statistics_file_mutex;
 
     // Output to file
     //-------------------------------------------------------------------------------
     std::ofstream statistics_file;
     void new_statistics_file();
-    void write_statistics_line_population(const population_t & pop, const std::vector<optimizer_pt> & local_optimizers, const std::vector<solution_pt> & elitist_archive);
-    void write_statistics_line_cluster(const population_t & cluster_pop,int cluster_number,  int cluster_generation, const std::vector<optimizer_pt> & local_optimizers, const std::vector<solution_pt> & elitist_archive);
+    void write_statistics_line_population(const population_t & pop, const std::vector<optimizer_pt> & local_optimizers, const elitist_archive_t & elitist_archive);
+    void write_statistics_line_cluster(const population_t & cluster_pop,int cluster_number,  int cluster_generation, const std::vector<optimizer_pt> & local_optimizers, const elitist_archive_t & elitist_archive);
     void close_statistics_file();
     void write_population_file(population_pt pop, std::vector<optimizer_pt> & local_optimizers) const; 
     void write_selection_file(population_pt pop, std::vector<optimizer_pt> & local_optimizers) const;
     void write_cluster_population(int generation_nuber, size_t cluster_number, int cluster_generation, population_pt pop) const;
-    void write_elitist_archive_file(const std::vector<solution_pt> & elitist_archive, bool final) const;
+    void write_elitist_archive_file(const elitist_archive_t & elitist_archive, bool final) const;
     void write_CEC2013_niching_file(bool final);
 
   };
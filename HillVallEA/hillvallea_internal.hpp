@@ -23,6 +23,8 @@ github.com/SCMaree/HillVallEA
 #include <functional>
 #include <memory>
 
+#include "philox.hpp"
+
 /*-=-=-=-=-=-=-=-=-=-=-=-=-=-= Section Constants -=-=-=-=-=-=-=-=-=-=-=-=-=-*/
 #ifndef PI
 #define PI 3.14159265358979323846264338327950288419716939937510582097494459230781640628620899862803482534211706798
@@ -43,6 +45,8 @@ namespace hillvallea {
   class iamalgam_t;
   class cmsaes_t;
   class iamalgam_univariate_t;
+  class lmmaes_t;
+  class amalgam_block_t;
   class vec_t;
 
   typedef std::shared_ptr<solution_t> solution_pt;
@@ -57,11 +61,28 @@ namespace hillvallea {
   typedef std::shared_ptr<amalgam_univariate_t> amalgam_univariate_pt;
   typedef std::shared_ptr<iamalgam_t> iamalgam_pt;
   typedef std::shared_ptr<iamalgam_univariate_t> iamalgam_univariate_pt;
-  typedef std::mt19937 rng_t;
-  typedef std::shared_ptr<std::mt19937> rng_pt;
+  typedef std::shared_ptr<lmmaes_t> lmmaes_pt;
+  typedef std::shared_ptr<amalgam_block_t> amalgam_block_pt;
+  typedef philox_t rng_t;
+  typedef std::shared_ptr<rng_t> rng_pt;
 
   class fitness_t;
   typedef std::shared_ptr<fitness_t> fitness_pt;
+
+  class thread_pool_t;
+  typedef std::shared_ptr<thread_pool_t> thread_pool_pt;
+
+  class kdtree_t;
+  typedef std::shared_ptr<kdtree_t> kdtree_pt;
+
+  class elitist_archive_t;
+
+  class population_soa_t;
+  class solution_view_t;
+  typedef std::shared_ptr<population_soa_t> population_soa_pt;
+
+  class solution_pool_t;
+  typedef std::shared_ptr<solution_pool_t> solution_pool_pt;
   
 }
 
@@ -30,12 +30,13 @@ namespace hillvallea
     // Essential data members
     //-------------------------------------------
     vec_t mean;                        // sample mean
-    matrix_t aggregated_covariance;    //  aggregated over multiple generations
-    matrix_t generational_covariance;  // estimated in this generation
+    vec_t aggregated_covariance;       //  aggregated over multiple generations
+    vec_t generational_covariance;     // estimated in this generation
 
-    matrix_t covariance;              //  covariance used for sampling
-    matrix_t cholesky;                // decomposed covariance matrix C = LL^T
-    matrix_t inverse_cholesky;        // inverse of the cholesky decomposition
+    // all covariance matrices are diagonal, only the diagonals are stored
+    vec_t covariance;                 //  covariance used for sampling
+    vec_t cholesky;                   // decomposed covariance matrix C = LL^T
+    vec_t inverse_cholesky;           // inverse of the cholesky decomposition
 
     vec_t ams_direction;
 
@@ -73,7 +74,7 @@ namespace hillvallea
     // AMS & SDR
     //-------------------------------------------
     void apply_ams_to_population(const size_t number_of_ams_solutions, const double ams_factor, const vec_t & ams_direction);
-    double getSDR(const solution_t & best, const vec_t & mean, matrix_t & cholesky_factor) const;
+    double getSDR(const solution_t & best, const vec_t & mean, vec_t & cholesky_factor) const;
     void update_distribution_multiplier(double & multiplier, const bool improvement, double & no_improvement_stretch, const double & sample_success_ratio, const double sdr) const;
     
     // Debug info
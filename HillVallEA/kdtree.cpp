@@ -0,0 +1,150 @@
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+
+*/
+
+#include "kdtree.hpp"
+#include "distance.hpp"
+
+namespace hillvallea
+{
+
+  // marks a missing child
+  static const size_t no_node = (size_t) -1;
+
+  kdtree_t::kdtree_t(size_t number_of_parameters)
+  {
+    this->number_of_parameters = number_of_parameters;
+  }
+
+  kdtree_t::~kdtree_t() {}
+
+  size_t kdtree_t::size() const
+  {
+    return split_dimension.size();
+  }
+
+  void kdtree_t::clear()
+  {
+    points.clear();
+    split_dimension.clear();
+    left.clear();
+    right.clear();
+  }
+
+  size_t kdtree_t::insert(const vec_t & point)
+  {
+    assert(point.size() == number_of_parameters);
+
+    size_t index = size();
+    points.insert(points.end(), point.begin(), point.end());
+    left.push_back(no_node);
+    right.push_back(no_node);
+
+    if (index == 0) {
+      split_dimension.push_back(0);
+      return index;
+    }
+
+    // descend to the leaf this point belongs to
+    size_t node = 0;
+    size_t depth = 0;
+
+    while (true)
+    {
+      depth++;
+      size_t & child = (point[split_dimension[node]] < points[node * number_of_parameters + split_dimension[node]]) ? left[node] : right[node];
+
+      if (child == no_node) {
+        child = index;
+        break;
+      }
+
+      node = child;
+    }
+
+    split_dimension.push_back(depth % number_of_parameters);
+    return index;
+  }
+
+  // same arithmetic as (query - point).norm()
+  double kdtree_t::distance(const vec_t & query, size_t index) const
+  {
+    return sqrt(squared_distance(query.data(), &points[index * number_of_parameters], number_of_parameters));
+  }
+
+  void kdtree_t::nearest(const vec_t & query, size_t k, size_t max_index, std::vector<size_t> & indices, vec_t & distances, const std::function<bool(size_t)> & accept) const
+  {
+    indices.clear();
+    distances.clear();
+
+    if (k == 0 || size() == 0 || max_index == 0) {
+      return;
+    }
+
+    // subtrees are only skipped if they are clearly farther away than the k-th
+    // nearest, so that round-off never changes the result (or its tie-breaking)
+    const double slack = 1.0 + 1e-12;
+
+    // nodes to visit, with a lower bound on the distance to their points
+    std::vector<std::pair<size_t, double>> stack;
+    stack.push_back(std::make_pair((size_t) 0, 0.0));
+
+    while (stack.size() > 0)
+    {
+      size_t node = stack.back().first;
+      double bound = stack.back().second;
+      stack.pop_back();
+
+      // all points below this node are inserted later
+      if (node == no_node || node >= max_index) {
+        continue;
+      }
+
+      if (distances.size() == k && bound > distances.back() * slack) {
+        continue;
+      }
+
+      // offer this point
+      bool accepted = (accept == nullptr || accept(node));
+      double dist = accepted ? distance(query, node) : 0.0;
+
+      if (accepted && (distances.size() < k || !(dist > distances.back())))
+      {
+        size_t pos = std::lower_bound(distances.begin(), distances.end(), dist) - distances.begin();
+
+        if (pos < distances.size() && distances[pos] == dist)
+        {
+          if (node < indices[pos]) {
+            indices[pos] = node;
+          }
+        }
+        else
+        {
+          distances.insert(distances.begin() + pos, dist);
+          indices.insert(indices.begin() + pos, node);
+
+          if (distances.size() > k) {
+            distances.pop_back();
+            indices.pop_back();
+          }
+        }
+      }
+
+      // visit the near side first, so it is pushed last
+      double diff = query[split_dimension[node]] - points[node * number_of_parameters + split_dimension[node]];
+      size_t near_child = (diff < 0) ? left[node] : right[node];
+      size_t far_child = (diff < 0) ? right[node] : left[node];
+
+      stack.push_back(std::make_pair(far_child, std::max(bound, fabs(diff))));
+      stack.push_back(std::make_pair(near_child, bound));
+    }
+  }
+
+}
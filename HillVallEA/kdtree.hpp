@@ -0,0 +1,60 @@
+#pragma once
+
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+*/
+
+#include "hillvallea_internal.hpp"
+#include "param.hpp"
+
+namespace hillvallea
+{
+
+  // kd-tree for nearest neighbour queries
+  // Points are inserted one by one and get the index of their insertion. The tree
+  // is built incrementally, so every point is inserted below the points with a lower
+  // index. A query that only considers points with index < max_index therefore
+  // returns the same as it would on the tree after inserting max_index points.
+  //-------------------------------------------------------------------------------
+  class kdtree_t
+  {
+
+  public:
+
+    kdtree_t(size_t number_of_parameters);
+    ~kdtree_t();
+
+    // adds a point, its index is the number of points inserted before it
+    size_t insert(const vec_t & point);
+    size_t size() const;
+    void clear();
+
+    // finds the (at most) k nearest points with index < max_index, ordered by
+    // distance. Equal distances are reported once, by their lowest index.
+    // distances are computed as in solution_t::param_distance.
+    // if accept is given, only points for which accept(index) is true are reported.
+    void nearest(const vec_t & query, size_t k, size_t max_index, std::vector<size_t> & indices, vec_t & distances, const std::function<bool(size_t)> & accept = nullptr) const;
+
+  private:
+
+    double distance(const vec_t & query, size_t index) const;
+
+    size_t number_of_parameters;
+
+    // the points, stored contiguously (row-major)
+    vec_t points;
+
+    // the tree: node i holds point i
+    std::vector<size_t> split_dimension;
+    std::vector<size_t> left;
+    std::vector<size_t> right;
+
+  };
+
+}
@@ -0,0 +1,467 @@
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+
+*/
+
+// The vectorized variants below must perform exactly the scalar arithmetic.
+// avx512f implies fma, so contraction of a * b + c is switched off for this file.
+#pragma GCC optimize ("fp-contract=off")
+
+#include "linalg.hpp"
+#include "dimension.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HILLVALLEA_X86_DISPATCH
+#endif
+
+namespace hillvallea
+{
+
+  // tile sizes of C: a tile of rows x columns is updated with all m rows of X,
+  // so that it stays in cache while X is streamed through.
+  static const size_t syrk_tile_rows = 32;
+  static const size_t syrk_tile_cols = 256;
+
+  // the kernels are written once and compiled for each instruction set
+  // by inlining them into the target-specific functions below.
+  __attribute__((always_inline))
+  static inline void syrk_upper_kernel(const double * X, size_t m, size_t n, size_t ldx, const double * w, double * C, size_t ldc)
+  {
+    for (size_t i0 = 0; i0 < n; i0 += syrk_tile_rows)
+    {
+      size_t i1 = std::min(i0 + syrk_tile_rows, n);
+
+      for (size_t j0 = i0; j0 < n; j0 += syrk_tile_cols)
+      {
+        size_t j1 = std::min(j0 + syrk_tile_cols, n);
+
+        for (size_t k = 0; k < m; ++k)
+        {
+          const double * x = X + k * ldx;
+          double wk = (w == nullptr) ? 1.0 : w[k];
+
+          for (size_t i = i0; i < i1; ++i)
+          {
+            double a = (w == nullptr) ? x[i] : wk * x[i];
+            double * c = C + i * ldc;
+
+            for (size_t j = std::max(i, j0); j < j1; ++j) {
+              c[j] += a * x[j];
+            }
+          }
+        }
+      }
+    }
+  }
+
+  static void syrk_upper_default(const double * X, size_t m, size_t n, size_t ldx, const double * w, double * C, size_t ldc)
+  {
+    syrk_upper_kernel(X, m, n, ldx, w, C, ldc);
+  }
+
+#ifdef HILLVALLEA_X86_DISPATCH
+
+  __attribute__((target("avx2")))
+  static void syrk_upper_avx2(const double * X, size_t m, size_t n, size_t ldx, const double * w, double * C, size_t ldc)
+  {
+    syrk_upper_kernel(X, m, n, ldx, w, C, ldc);
+  }
+
+  __attribute__((target("avx512f")))
+  static void syrk_upper_avx512(const double * X, size_t m, size_t n, size_t ldx, const double * w, double * C, size_t ldc)
+  {
+    syrk_upper_kernel(X, m, n, ldx, w, C, ldc);
+  }
+
+#endif
+
+  // Cholesky decomposition
+  // Entry (j,i) of L is computed as in LINPACK DCHDC (without pivoting): the products
+  // L[j][k] * L[i][k] are subtracted for k = 0, 1, ..., i-1 in order, after which
+  // the entry is divided by L[i][i] (or square-rooted on the diagonal). The columns
+  // are processed in panels; the update of the trailing matrix by a panel is deferred
+  // and done tile by tile. Column k of L is mirrored into row k of the (unused) upper
+  // triangle, so that the updates read contiguous rows only.
+  //-------------------------------------------------------------------------------
+  static const size_t cholesky_panel = 32;
+  static const size_t cholesky_tile = 128;
+
+  __attribute__((always_inline))
+  static inline bool cholesky_lower_kernel(double * A, size_t n, size_t ld)
+  {
+    for (size_t k0 = 0; k0 < n; k0 += cholesky_panel)
+    {
+      size_t k1 = std::min(k0 + cholesky_panel, n);
+
+      // factor the panel
+      for (size_t k = k0; k < k1; ++k)
+      {
+        double * ak = A + k * ld;
+
+        if (ak[k] <= 0.0) {
+          return false;
+        }
+
+        ak[k] = sqrt(ak[k]);
+
+        for (size_t j = k + 1; j < n; ++j)
+        {
+          double * aj = A + j * ld;
+          aj[k] = aj[k] / ak[k];
+          ak[j] = aj[k];
+        }
+
+        for (size_t j = k + 1; j < n; ++j)
+        {
+          double * aj = A + j * ld;
+          double l = aj[k];
+          size_t i1 = std::min(j + 1, k1);
+
+          for (size_t i = k + 1; i < i1; ++i) {
+            aj[i] -= l * ak[i];
+          }
+        }
+      }
+
+      // update the trailing matrix with the panel
+      for (size_t i0 = k1; i0 < n; i0 += cholesky_tile)
+      {
+        size_t i1 = std::min(i0 + cholesky_tile, n);
+
+        for (size_t j = i0; j < n; ++j)
+        {
+          double * aj = A + j * ld;
+          size_t ie = std::min(j + 1, i1);
+
+          for (size_t k = k0; k < k1; ++k)
+          {
+            const double * ak = A + k * ld;
+            double l = aj[k];
+
+            for (size_t i = i0; i < ie; ++i) {
+              aj[i] -= l * ak[i];
+            }
+          }
+        }
+      }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+      std::fill(A + i * ld + i + 1, A + i * ld + n, 0.0);
+    }
+
+    return true;
+  }
+
+  // Triangular inverse
+  // U = L^T, so row k of U is column k of L. As in LINPACK DTRDI, column j of the
+  // inverse X is obtained by adding L[k][j] * X[.][k] for k = n-1, ..., j+1 in order,
+  // and scaling by -X[j][j] = -1/L[j][j]. Columns are processed in blocks (from the
+  // last to the first), first applying all columns after the block, so that each row
+  // of U is loaded once per block.
+  //-------------------------------------------------------------------------------
+  static const size_t inverse_block = 32;
+
+  // apply the (inverted) columns k in [ka, kb) of X to the columns j in [j0, j1)
+  __attribute__((always_inline))
+  static inline void inverse_update_kernel(double * U, size_t n, size_t ld, size_t j0, size_t j1, size_t ka, size_t kb)
+  {
+    for (size_t k = kb; k-- > ka; )
+    {
+      const double * uk = U + k * ld;
+
+      for (size_t j = j0; j < j1; ++j)
+      {
+        double * uj = U + j * ld;
+        double l = uj[k];
+        uj[k] = 0.0;
+
+        if (l != 0.0)
+        {
+          for (size_t r = k; r < n; ++r) {
+            uj[r] += l * uk[r];
+          }
+        }
+      }
+    }
+  }
+
+  __attribute__((always_inline))
+  static inline bool lower_triangular_inverse_kernel(double * U, size_t n, size_t ld)
+  {
+    // columns after the last zero on the diagonal are inverted
+    size_t first = 0;
+    for (size_t k = n; k-- > 0; )
+    {
+      if (U[k * ld + k] == 0.0) {
+        first = k + 1;
+        break;
+      }
+    }
+
+    for (size_t j1 = n; j1 > first; )
+    {
+      size_t j0 = (j1 - first > inverse_block) ? j1 - inverse_block : first;
+
+      inverse_update_kernel(U, n, ld, j0, j1, j1, n);
+
+      for (size_t k = j1; k-- > j0; )
+      {
+        double * uk = U + k * ld;
+        uk[k] = 1.0 / uk[k];
+        double scale = -uk[k];
+
+        for (size_t r = k + 1; r < n; ++r) {
+          uk[r] = scale * uk[r];
+        }
+
+        inverse_update_kernel(U, n, ld, j0, k, k, k + 1);
+      }
+
+      j1 = j0;
+    }
+
+    if (first > 0) {
+      inverse_update_kernel(U, n, ld, 0, first, first, n);
+      return false;
+    }
+
+    return true;
+  }
+
+  static bool cholesky_lower_default(double * A, size_t n, size_t ld) { return cholesky_lower_kernel(A, n, ld); }
+  static bool lower_triangular_inverse_default(double * U, size_t n, size_t ld) { return lower_triangular_inverse_kernel(U, n, ld); }
+
+#ifdef HILLVALLEA_X86_DISPATCH
+
+  __attribute__((target("avx2")))
+  static bool cholesky_lower_avx2(double * A, size_t n, size_t ld) { return cholesky_lower_kernel(A, n, ld); }
+
+  __attribute__((target("avx512f")))
+  static bool cholesky_lower_avx512(double * A, size_t n, size_t ld) { return cholesky_lower_kernel(A, n, ld); }
+
+  __attribute__((target("avx2")))
+  static bool lower_triangular_inverse_avx2(double * U, size_t n, size_t ld) { return lower_triangular_inverse_kernel(U, n, ld); }
+
+  __attribute__((target("avx512f")))
+  static bool lower_triangular_inverse_avx512(double * U, size_t n, size_t ld) { return lower_triangular_inverse_kernel(U, n, ld); }
+
+#endif
+
+  // matrix-vector product
+  // y[i] = sum_j A[i][j] * x[j], summed over j in order.
+  //-------------------------------------------------------------------------------
+  __attribute__((always_inline))
+  static inline void matrix_vector_product_kernel(const double * A, size_t n, size_t ld, const double * x, double * y)
+  {
+    for (size_t i = 0; i < n; ++i)
+    {
+      const double * a = A + i * ld;
+      double v = 0.0;
+
+      for (size_t j = 0; j < n; ++j) {
+        v += a[j] * x[j];
+      }
+
+      y[i] = v;
+    }
+  }
+
+  // triangular matrix multiply
+  // B <- L B in place, row i of the result is sum_{j <= i} L[i][j] * B[j], summed
+  // over j in order. Rows are computed from the last to the first, so that the rows
+  // j <= i are still unchanged. The columns are processed in blocks that fit in cache,
+  // and within a block all columns are updated at once.
+  //-------------------------------------------------------------------------------
+  static const size_t trmm_block = 64;
+
+  __attribute__((always_inline))
+  static inline void trmm_lower_kernel(const double * L, size_t n, size_t ldl, double * B, size_t m, size_t ldb)
+  {
+    double acc[trmm_block];
+
+    for (size_t k0 = 0; k0 < m; k0 += trmm_block)
+    {
+      size_t kb = std::min(trmm_block, m - k0);
+
+      for (size_t i = n; i-- > 0; )
+      {
+        const double * l = L + i * ldl;
+
+        for (size_t k = 0; k < kb; ++k) {
+          acc[k] = 0.0;
+        }
+
+        for (size_t j = 0; j <= i; ++j)
+        {
+          const double * b = B + j * ldb + k0;
+          double lij = l[j];
+
+          for (size_t k = 0; k < kb; ++k) {
+            acc[k] += lij * b[k];
+          }
+        }
+
+        std::copy(acc, acc + kb, B + i * ldb + k0);
+      }
+    }
+  }
+
+  static void trmm_lower_default(const double * L, size_t n, size_t ldl, double * B, size_t m, size_t ldb) { trmm_lower_kernel(L, n, ldl, B, m, ldb); }
+
+#ifdef HILLVALLEA_X86_DISPATCH
+
+  __attribute__((target("avx2")))
+  static void trmm_lower_avx2(const double * L, size_t n, size_t ldl, double * B, size_t m, size_t ldb) { trmm_lower_kernel(L, n, ldl, B, m, ldb); }
+
+  __attribute__((target("avx512f")))
+  static void trmm_lower_avx512(const double * L, size_t n, size_t ldl, double * B, size_t m, size_t ldb) { trmm_lower_kernel(L, n, ldl, B, m, ldb); }
+
+#endif
+
+  // instantiations for the fixed problem sizes (see dimension.hpp). At these sizes the
+  // default instruction set is used; the loops are unrolled rather than vectorized.
+  //-------------------------------------------------------------------------------
+  struct syrk_upper_fixed_t
+  {
+    typedef void (*function_t)(const double *, size_t, size_t, size_t, const double *, double *, size_t);
+    template <size_t D> static void run(const double * X, size_t m, size_t n, size_t ldx, const double * w, double * C, size_t ldc) { syrk_upper_kernel(X, m, fixed_dimension<D>(n), ldx, w, C, ldc); }
+  };
+
+  struct cholesky_lower_fixed_t
+  {
+    typedef bool (*function_t)(double *, size_t, size_t);
+    template <size_t D> static bool run(double * A, size_t n, size_t ld) { return cholesky_lower_kernel(A, fixed_dimension<D>(n), ld); }
+  };
+
+  struct lower_triangular_inverse_fixed_t
+  {
+    typedef bool (*function_t)(double *, size_t, size_t);
+    template <size_t D> static bool run(double * U, size_t n, size_t ld) { return lower_triangular_inverse_kernel(U, fixed_dimension<D>(n), ld); }
+  };
+
+  struct matrix_vector_product_t
+  {
+    typedef void (*function_t)(const double *, size_t, size_t, const double *, double *);
+    template <size_t D> static void run(const double * A, size_t n, size_t ld, const double * x, double * y) { matrix_vector_product_kernel(A, fixed_dimension<D>(n), ld, x, y); }
+  };
+
+  struct trmm_lower_fixed_t
+  {
+    typedef void (*function_t)(const double *, size_t, size_t, double *, size_t, size_t);
+    template <size_t D> static void run(const double * L, size_t n, size_t ldl, double * B, size_t m, size_t ldb) { trmm_lower_kernel(L, fixed_dimension<D>(n), ldl, B, m, ldb); }
+  };
+
+  // kernel selection, once, on first use
+  //-------------------------------------------------------------------------------
+  enum linalg_isa_t { linalg_default, linalg_avx2, linalg_avx512 };
+
+  static linalg_isa_t linalg_isa()
+  {
+    static const linalg_isa_t isa = []()
+    {
+#ifdef HILLVALLEA_X86_DISPATCH
+      __builtin_cpu_init();
+
+      if (__builtin_cpu_supports("avx512f")) {
+        return linalg_avx512;
+      }
+
+      if (__builtin_cpu_supports("avx2")) {
+        return linalg_avx2;
+      }
+#endif
+      return linalg_default;
+    }();
+
+    return isa;
+  }
+
+  void syrk_upper(const double * X, size_t m, size_t n, size_t ldx, const double * w, matrix_t & C)
+  {
+    assert(C.rows() >= n && C.cols() >= n);
+
+    if (is_fixed_dimension(n)) {
+      dimension_dispatch<syrk_upper_fixed_t>(n)(X, m, n, ldx, w, C.data(), C.leading_dimension());
+      return;
+    }
+
+    switch (linalg_isa())
+    {
+#ifdef HILLVALLEA_X86_DISPATCH
+      case linalg_avx512: syrk_upper_avx512(X, m, n, ldx, w, C.data(), C.leading_dimension()); break;
+      case linalg_avx2: syrk_upper_avx2(X, m, n, ldx, w, C.data(), C.leading_dimension()); break;
+#endif
+      default: syrk_upper_default(X, m, n, ldx, w, C.data(), C.leading_dimension()); break;
+    }
+  }
+
+  bool cholesky_lower(matrix_t & A)
+  {
+    assert(A.rows() == A.cols());
+
+    if (is_fixed_dimension(A.rows())) {
+      return dimension_dispatch<cholesky_lower_fixed_t>(A.rows())(A.data(), A.rows(), A.leading_dimension());
+    }
+
+    switch (linalg_isa())
+    {
+#ifdef HILLVALLEA_X86_DISPATCH
+      case linalg_avx512: return cholesky_lower_avx512(A.data(), A.rows(), A.leading_dimension());
+      case linalg_avx2: return cholesky_lower_avx2(A.data(), A.rows(), A.leading_dimension());
+#endif
+      default: return cholesky_lower_default(A.data(), A.rows(), A.leading_dimension());
+    }
+  }
+
+  bool lower_triangular_inverse_transposed(matrix_t & U)
+  {
+    assert(U.rows() == U.cols());
+
+    if (is_fixed_dimension(U.rows())) {
+      return dimension_dispatch<lower_triangular_inverse_fixed_t>(U.rows())(U.data(), U.rows(), U.leading_dimension());
+    }
+
+    switch (linalg_isa())
+    {
+#ifdef HILLVALLEA_X86_DISPATCH
+      case linalg_avx512: return lower_triangular_inverse_avx512(U.data(), U.rows(), U.leading_dimension());
+      case linalg_avx2: return lower_triangular_inverse_avx2(U.data(), U.rows(), U.leading_dimension());
+#endif
+      default: return lower_triangular_inverse_default(U.data(), U.rows(), U.leading_dimension());
+    }
+  }
+
+  void matrix_vector_product(const matrix_t & A, const double * x, double * y)
+  {
+    assert(A.rows() == A.cols());
+    dimension_dispatch<matrix_vector_product_t>(A.rows())(A.data(), A.rows(), A.leading_dimension(), x, y);
+  }
+
+  void trmm_lower(const matrix_t & L, double * B, size_t m, size_t ldb)
+  {
+    assert(L.rows() == L.cols());
+    size_t n = L.rows();
+
+    if (is_fixed_dimension(n)) {
+      dimension_dispatch<trmm_lower_fixed_t>(n)(L.data(), n, L.leading_dimension(), B, m, ldb);
+      return;
+    }
+
+    switch (linalg_isa())
+    {
+#ifdef HILLVALLEA_X86_DISPATCH
+      case linalg_avx512: trmm_lower_avx512(L.data(), n, L.leading_dimension(), B, m, ldb); break;
+      case linalg_avx2: trmm_lower_avx2(L.data(), n, L.leading_dimension(), B, m, ldb); break;
+#endif
+      default: trmm_lower_default(L.data(), n, L.leading_dimension(), B, m, ldb); break;
+    }
+  }
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+*/
+
+#include "hillvallea_internal.hpp"
+#include "param.hpp"
+
+namespace hillvallea
+{
+
+  // Dense linear algebra kernels on contiguous, row-major blocks
+  // The kernels are cache-blocked and vectorized (AVX-512 or AVX2, picked at
+  // runtime, with a plain fallback), or, for the fixed problem sizes of
+  // dimension.hpp, compiled for that size. Each entry is computed with the same
+  // sequence of operations as the straightforward loops, so results do not
+  // depend on the instruction set or the problem size specialization.
+  //-------------------------------------------------------------------------------
+
+  // symmetric rank-k update of the upper triangle of C (n x n):
+  // C[i][j] += sum_k (w[k] * X[k][i]) * X[k][j] for j >= i, over the m rows of the
+  // row-major X with leading dimension ldx. w[k] = 1 if w is nullptr.
+  // Every entry is accumulated over k in order.
+  void syrk_upper(const double * X, size_t m, size_t n, size_t ldx, const double * w, matrix_t & C);
+
+  // in-place Cholesky decomposition A = LL^T of the symmetric matrix A (n x n).
+  // Only the lower triangle of A is read. On success, A holds L with zeros above
+  // the diagonal. Returns false, with A partially overwritten, if A is not
+  // positive definite. Blocked right-looking algorithm; no allocations.
+  bool cholesky_lower(matrix_t & A);
+
+  // in-place inverse of a lower triangular matrix L that is stored transposed,
+  // i.e., U = L^T is stored in the upper triangle of U (n x n), so that the
+  // columns of L are contiguous. On return, U holds (L^-1)^T.
+  // If L has a zero on its diagonal, only the columns of L after the last zero
+  // are inverted and false is returned (as LINPACK DTRDI does).
+  bool lower_triangular_inverse_transposed(matrix_t & U);
+
+  // y = A x for the square matrix A, with A.rows() entries in x and y (not aliased).
+  // Each entry is summed over the columns in order.
+  void matrix_vector_product(const matrix_t & A, const double * x, double * y);
+
+  // B <- L B in place, for the lower triangular L (n x n, entries above the diagonal
+  // are not read) and the row-major n x m block B with leading dimension ldb.
+  // Each entry is summed over the columns of L in order, as in matrix_vector_product.
+  void trmm_lower(const matrix_t & L, double * B, size_t m, size_t ldb);
+
+}
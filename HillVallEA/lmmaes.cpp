@@ -0,0 +1,403 @@
+/*
+
+LM-MA-ES as part of HillVallEA
+
+Implementation by S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+*/
+
+#include "population.hpp"
+#include "mathfunctions.hpp"
+#include "normal_generator.hpp"
+#include "lmmaes.hpp"
+
+
+// init LM-MA-ES default parameters
+hillvallea::lmmaes_t::lmmaes_t(const size_t number_of_parameters, const vec_t & lower_param_bounds, const vec_t & upper_param_bounds, double init_univariate_bandwidth, fitness_pt fitness_function, rng_pt rng) : optimizer_t(number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, rng)
+{
+
+  maximum_no_improvement_stretch = (int)(25 + number_of_parameters);
+  selection_fraction = 0.5;
+  param_std_tolerance = 1e-10;
+  fitness_std_tolerance = 1e-10;
+
+  number_of_directions = (size_t)(4 + floor(3.0 * log((double)number_of_parameters)));
+  directions.assign(number_of_directions, vec_t(number_of_parameters, 0.0));
+  p_sigma.resize(number_of_parameters, 0.0);
+  scaling.resize(number_of_parameters, 1.0);
+  sigma = 1.0;
+
+  size_t stallsize = (size_t)(10 + floor(30.0 * number_of_parameters / recommended_popsize(number_of_parameters)));  // Stall time(for termination criterion)
+  bestf_NE.resize(stallsize, 0.0);
+
+  for (size_t i = 0; i < stallsize; ++i)
+  {
+    bestf_NE[i] = (stallsize - i)*(1e140);
+  }
+
+}
+
+hillvallea::lmmaes_t::~lmmaes_t() {};
+
+// Algorithm name
+std::string hillvallea::lmmaes_t::name() const { return "LM-MA-ES"; }
+
+hillvallea::optimizer_pt hillvallea::lmmaes_t::clone() const
+{
+
+  lmmaes_pt opt = std::make_shared<lmmaes_t>(number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, rng);
+
+  // Optimizer data members
+  //-------------------------------------------
+  opt->active = active;
+  opt->number_of_parameters = number_of_parameters;
+  opt->lower_param_bounds = lower_param_bounds;
+  opt->upper_param_bounds = upper_param_bounds;
+  opt->fitness_function = fitness_function;
+  opt->number_of_generations = number_of_generations;
+  opt->rng = rng;
+  opt->pop = std::make_shared<population_t>(); //!! A copy of the contents, not the pointer
+  opt->pop->solution_pool = pop->solution_pool;
+  opt->pop->addSolutions(*pop);
+  opt->best = best;
+  opt->average_fitness_history = average_fitness_history;
+  opt->selection_fraction = selection_fraction;
+  opt->init_univariate_bandwidth = init_univariate_bandwidth;
+
+  // Stopping criteria
+  //----------------------------------------------------------------------------------
+  opt->maximum_no_improvement_stretch = maximum_no_improvement_stretch;
+  opt->param_std_tolerance = param_std_tolerance;
+  opt->fitness_std_tolerance = fitness_std_tolerance;
+  opt->number_of_drawn_samples = number_of_drawn_samples;
+  opt->number_of_rejected_samples = number_of_rejected_samples;
+
+  // LM-MA-ES Parameters
+  //---------------------------------------------------------------------------------
+  opt->lambda = lambda;
+  opt->mu = mu;
+  opt->mu_eff = mu_eff;
+  opt->sigma = sigma;
+  opt->c_sigma = c_sigma;
+  opt->c_d = c_d;
+  opt->c_c = c_c;
+  opt->number_of_directions = number_of_directions;
+  opt->bestf_NE = bestf_NE;
+  opt->weights = weights;
+  opt->mean = mean;
+  opt->scaling = scaling;
+  opt->p_sigma = p_sigma;
+  opt->directions = directions;
+  opt->z_samples = z_samples;
+  opt->no_improvement_stretch = no_improvement_stretch;
+
+  return opt;
+}
+
+
+// returns true if any of the termination criteria is satisfied
+bool hillvallea::lmmaes_t::checkTerminationCondition()
+{
+
+  // check the cluster size
+  if (pop->size() == 0) {
+    active = false;
+    return !active;
+  }
+
+  // the largest parameter std of the (untransformed) distribution
+  double max_param_std = sigma * scaling.max_elem();
+
+  // Check imp over time
+  size_t stallsize = (size_t)(10 + floor(30.0 * number_of_parameters / recommended_popsize(number_of_parameters)));  // Stall time(for termination criterion)
+  double TolHistFun = 1e-5;
+  double bestf_NEmin = 1e308;
+  double bestf_NEmax = -1e308;
+  for (size_t i = this->bestf_NE.size() - stallsize; i < this->bestf_NE.size(); ++i)
+  {
+    if (this->bestf_NE[i] < bestf_NEmin)
+      bestf_NEmin = this->bestf_NE[i];
+
+    if (this->bestf_NE[i] > bestf_NEmax)
+      bestf_NEmax = this->bestf_NE[i];
+  }
+  double max_diff = bestf_NEmax - bestf_NEmin;
+
+  vec_t mean;
+  pop->mean(mean);
+
+  // if the mean equals zero, we can't didivide by it, so terminate it when it is kinda small
+  bool terminate_for_param_std_mean_zero = (mean.infinitynorm() <= 0 && max_param_std < param_std_tolerance);
+  bool terminate_on_parameter_std = max_param_std / mean.infinitynorm() < param_std_tolerance;
+  bool terminate_on_fitness_std = (pop->size() > 1) && (pop->relative_fitness_std() < fitness_std_tolerance);
+  bool terminate_on_huge_multiplier = (sigma > 1e+300);
+  bool terminate_on_slow_improvement = max_diff < TolHistFun;
+
+  if (terminate_for_param_std_mean_zero || terminate_on_parameter_std || terminate_on_fitness_std || terminate_on_huge_multiplier || terminate_on_slow_improvement)
+  {
+    active = false;
+    return !active;
+  }
+
+  // if we have not terminated so far, the cluster is active.
+  // if, due to selection, the cluster is shrunken, it is set to active again.
+  active = true;
+  return !active;
+
+}
+
+// The learning rates of Loshchilov et al.: c_sigma = 2 lambda / d, c_d[j] = 1 / (1.5^j d)
+// and c_c[j] = lambda / (4^j d). These exceed 1 for the low dimensions of most niching
+// problems, so c_sigma and c_c are capped at 1, and c_d at 1/2 such that each
+// rank-one update keeps half of the identity and remains invertible.
+void hillvallea::lmmaes_t::initStrategyParameters(const size_t selection_size)
+{
+
+  mu = selection_size;
+  lambda = std::max(mu + 1, (size_t)(mu / selection_fraction));
+
+  // Weights
+  weights.resize(mu);
+  double sum_weights = 0.0;
+  for (size_t i = 0; i < weights.size(); ++i)
+  {
+    weights[i] = log(mu + 1.0) - log(i + 1.0);
+    sum_weights += weights[i];
+  }
+
+  // normalize the weights
+  double sum_weights_squared = 0.0;
+  for (size_t i = 0; i < weights.size(); ++i) {
+    weights[i] /= sum_weights;
+    sum_weights_squared += weights[i] * weights[i];
+  }
+
+  mu_eff = 1.0 / sum_weights_squared;
+
+  c_sigma = std::min(1.0, 2.0 * lambda / number_of_parameters);
+
+  c_d.resize(number_of_directions);
+  c_c.resize(number_of_directions);
+  for (size_t j = 0; j < number_of_directions; ++j)
+  {
+    c_d[j] = std::min(0.5, 1.0 / (pow(1.5, (double)j) * number_of_parameters));
+    c_c[j] = std::min(1.0, lambda / (pow(4.0, (double)j) * number_of_parameters));
+  }
+
+}
+
+void hillvallea::lmmaes_t::initialize_from_population(population_pt pop)
+{
+  this->pop = pop;
+
+  initStrategyParameters(pop->size());
+
+  no_improvement_stretch = 0;
+  number_of_generations = 0;
+
+  pop->mean(mean);
+  best = *pop->first();
+
+  // the diagonal scaling is the univariate standard deviation of the cluster
+  if (pop->size() == 1)
+  {
+    scaling.resize(number_of_parameters);
+    scaling.fill(sqrt(init_univariate_bandwidth*0.01));
+  }
+  else
+  {
+    vec_t variances;
+    pop->covariance_univariate(mean, variances);
+    choleskyDecomposition_univariate(variances, scaling);
+  }
+
+  sigma = 1;
+  p_sigma.resize(number_of_parameters);
+  p_sigma.fill(0.0);
+  directions.assign(number_of_directions, vec_t(number_of_parameters, 0.0));
+
+  z_samples.assign(pop->size(), vec_t(number_of_parameters, 0.0));
+
+}
+
+size_t hillvallea::lmmaes_t::recommended_popsize(const size_t problem_dimension) const
+{
+  return (size_t)std::max((double)((size_t)((2.0 / selection_fraction) + 1)), 4.0 + floor(3.0 * log((double)problem_dimension)));
+}
+
+void hillvallea::lmmaes_t::estimate_sample_parameters()
+{
+
+  if (weights.size() != pop->size()) { // pop is selection
+    initStrategyParameters(pop->size());
+  }
+
+  pop->weighted_mean(mean, weights);
+
+  // the selected solutions were not sampled from this distribution yet
+  if (number_of_generations == 0) {
+    return;
+  }
+
+  // weighted sum of the selected samples
+  vec_t weighted_z(number_of_parameters, 0.0);
+  for (size_t k = 0; k < mu; ++k) {
+    weighted_z += weights[k] * z_samples[k];
+  }
+
+  // the step size path, and the paths of the directions
+  p_sigma = (1.0 - c_sigma) * p_sigma + sqrt(mu_eff * c_sigma * (2.0 - c_sigma)) * weighted_z;
+
+  for (size_t j = 0; j < number_of_directions; ++j) {
+    directions[j] = (1.0 - c_c[j]) * directions[j] + sqrt(mu_eff * c_c[j] * (2.0 - c_c[j])) * weighted_z;
+  }
+
+  sigma *= exp(0.5 * c_sigma * (p_sigma.squaredNorm() / number_of_parameters - 1.0));
+  assert(!isnan(sigma));
+
+}
+
+// d = z, transformed by the first number_of_used_directions rank-one updates
+void hillvallea::lmmaes_t::transform_sample(const vec_t & z, vec_t & d, const size_t number_of_used_directions) const
+{
+  d = z;
+
+  for (size_t j = 0; j < number_of_used_directions; ++j)
+  {
+    const vec_t & M = directions[j];
+
+    double projection = 0.0;
+    for (size_t i = 0; i < number_of_parameters; ++i) {
+      projection += M[i] * d[i];
+    }
+
+    double keep = 1.0 - c_d[j];
+    double shift = c_d[j] * projection;
+    for (size_t i = 0; i < number_of_parameters; ++i) {
+      d[i] = keep * d[i] + shift * M[i];
+    }
+  }
+}
+
+// the inverse of transform_sample, with each rank-one update inverted by Sherman-Morrison:
+//   ((1 - c) I + c M M^T)^{-1} = (I - c M M^T / (1 - c + c M^T M)) / (1 - c)
+void hillvallea::lmmaes_t::inverse_transform_sample(const vec_t & d, vec_t & z, const size_t number_of_used_directions) const
+{
+  z = d;
+
+  for (size_t j = number_of_used_directions; j-- > 0; )
+  {
+    const vec_t & M = directions[j];
+
+    double projection = 0.0;
+    for (size_t i = 0; i < number_of_parameters; ++i) {
+      projection += M[i] * z[i];
+    }
+
+    double keep = 1.0 - c_d[j];
+    double shift = c_d[j] * projection / (keep + c_d[j] * M.squaredNorm());
+    for (size_t i = 0; i < number_of_parameters; ++i) {
+      z[i] = (z[i] - shift * M[i]) / keep;
+    }
+  }
+}
+
+size_t hillvallea::lmmaes_t::sample_new_population(const size_t sample_size)
+{
+  // this is a new generation!
+  //---------------------------------------------------------------------------------------
+  number_of_generations++;
+
+  // the paths are updated once per generation, from the second generation on,
+  // and direction j is used once it has been updated j+1 times.
+  size_t number_of_used_directions = std::min(number_of_directions, (size_t)(number_of_generations - 1));
+
+  // Sample a new population
+  //--------------------------------------------
+  size_t number_of_elites = 1;
+  pop->sols.resize(sample_size);
+  z_samples.resize(sample_size, vec_t(number_of_parameters, 0.0));
+
+  vec_t d(number_of_parameters);
+
+  // for each sol in the pop, sample.
+  for (size_t i = 0; i < pop->sols.size(); ++i)
+  {
+
+    // save the elite (if it is defined). Its z is that of the previous distribution,
+    // so it is recomputed as if the elite was sampled from the current one.
+    // Otherwise, a lasting elite keeps pushing the paths in the same direction.
+    if (i < number_of_elites && pop->sols[i] != nullptr)
+    {
+      const vec_t & param = pop->sols[i]->param;
+      for (size_t j = 0; j < number_of_parameters; ++j) {
+        double scale = sigma * scaling[j];
+        d[j] = (scale > 0) ? (param[j] - mean[j]) / scale : 0.0;
+      }
+      inverse_transform_sample(d, z_samples[i], number_of_used_directions);
+      continue;
+    }
+
+    // if the solution is not yet initialized, do it now.
+    if (pop->sols[i] == nullptr)
+    {
+      solution_pt sol = pop->new_solution(number_of_parameters);
+      pop->sols[i] = sol;
+    }
+
+    // Sample independent standard normal variables Z = N(0,1),
+    // from substream i of the stream of this generation
+    rng_t sample_rng = rng->stream(number_of_generations).stream(i);
+    z_samples[i].resize(number_of_parameters);
+    standard_normals(sample_rng, z_samples[i].data(), number_of_parameters);
+
+    transform_sample(z_samples[i], d, number_of_used_directions);
+
+    vec_t & param = pop->sols[i]->param;
+    param.resize(number_of_parameters);
+    for (size_t j = 0; j < number_of_parameters; ++j) {
+      param[j] = mean[j] + sigma * scaling[j] * d[j];
+    }
+
+    // the transformation is not triangular, so out-of-range samples are
+    // repaired to the boundary, and z is kept as it was drawn
+    if (boundary_repair(param, lower_param_bounds, upper_param_bounds)) {
+      number_of_rejected_samples++;
+    }
+
+    number_of_drawn_samples++;
+
+  }
+
+  // evaluate the population
+  //---------------------------------------------------------------------------------------
+  size_t number_of_evaluations = pop->evaluate(fitness_function, 1);
+
+  // sort, and keep the samples in line with the solutions
+  std::vector<size_t> order;
+  pop->sort_on_fitness(order);
+
+  std::vector<vec_t> sorted_z_samples(order.size());
+  for (size_t k = 0; k < order.size(); ++k) {
+    sorted_z_samples[k].swap(z_samples[order[k]]);
+  }
+  z_samples.swap(sorted_z_samples);
+
+  // Update Params
+  //---------------------------------------------------------------------------------------
+  bool improvement = pop->improvement_over(best.f);
+
+  if (improvement)  {
+    no_improvement_stretch = 0;
+  }
+  else {
+    no_improvement_stretch++;
+  }
+
+  best = *pop->first();
+  bestf_NE.push_back(best.f);
+
+  return number_of_evaluations;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+/*
+
+LM-MA-ES as part of HillVallEA
+
+Implementation by S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+*/
+
+#include "hillvallea_internal.hpp"
+#include "optimizer.hpp"
+
+namespace hillvallea
+{
+
+  // Limited-Memory Matrix Adaptation Evolution Strategy
+  // Loshchilov, Glasmachers & Beyer, "Large Scale Black-box Optimization by
+  // Limited-Memory Matrix Adaptation", IEEE TEC, 2019.
+  // The search distribution is x = mean + sigma * D * d, with D a diagonal scaling
+  // estimated from the initial cluster, and d = z transformed by a product of
+  // rank-one updates along number_of_directions evolution paths M_j:
+  //   d <- (1 - c_d[j]) * d + c_d[j] * M_j * (M_j^T d),   j = 0, ..., number_of_directions-1.
+  // Memory and time per sample are O(number_of_directions * d), with
+  // number_of_directions = 4 + 3 ln(d), so that correlated search remains
+  // feasible in thousands of dimensions.
+  //-------------------------------------------------------------------------------
+  class lmmaes_t : public optimizer_t
+  {
+
+  public:
+
+    lmmaes_t(const size_t number_of_parameters, const vec_t & lower_param_bounds, const vec_t & upper_param_bounds, double init_univariate_bandwidth, fitness_pt fitness_function, rng_pt rng);
+    ~lmmaes_t();
+    optimizer_pt clone() const;
+
+    // LM-MA-ES Parameters
+    //---------------------------------------------------------------------------------
+    size_t lambda;                    // Population size
+    size_t mu;                        // Selection size
+    double mu_eff;                    // variance effective selection mass
+    double sigma;                     // step size
+    double c_sigma;                   // learning rate of the step size path
+    vec_t c_d, c_c;                   // learning rates of the directions, and of their paths
+    size_t number_of_directions;
+
+    vec_t bestf_NE;
+    vec_t weights;
+    vec_t mean;
+    vec_t scaling;                    // diagonal scaling D
+    vec_t p_sigma;                    // evolution path for the step size
+    std::vector<vec_t> directions;    // evolution paths M_j, filled over the first generations
+
+    // per-solution standard normal samples z, in line with pop->sols
+    std::vector<vec_t> z_samples;
+
+    double no_improvement_stretch; // a double as we average it a lot
+
+    // Initialization
+    //---------------------------------------------------------------------------------
+    void initialize_from_population(population_pt pop);
+    size_t recommended_popsize(const size_t problem_dimension) const;
+
+    // Run-time control
+    //---------------------------------------------------------------------------------
+    bool checkTerminationCondition();
+    void estimate_sample_parameters();
+    size_t sample_new_population(const size_t sample_size);
+    void initStrategyParameters(const size_t selection_size);
+    void transform_sample(const vec_t & z, vec_t & d, const size_t number_of_used_directions) const;
+    void inverse_transform_sample(const vec_t & d, vec_t & z, const size_t number_of_used_directions) const;
+
+    // debug info
+    //---------------------------------------------------------------------------------
+    std::string name() const;
+
+  };
+
+}
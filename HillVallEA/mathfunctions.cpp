@@ -10,6 +10,9 @@ github.com/SCMaree/HillVallEA
 
 #include "mathfunctions.hpp"
 #include "solution.hpp"
+#include "distance.hpp"
+#include "linalg.hpp"
+#include "normal_generator.hpp"
 
 namespace hillvallea 
 {
@@ -27,8 +30,7 @@ namespace hillvallea
   {
     
     choleskyDecomposition(cov, chol);
-    int n = (int)cov.rows();
-    inverse_chol.setRaw(matrixLowerTriangularInverse(chol.toArray(), n),n,n);
+    matrixLowerTriangularInverse(chol, inverse_chol);
     
     return normpdf(mean,chol,inverse_chol,x);
     
@@ -111,89 +113,160 @@ namespace hillvallea
   // sample the parameter from a normal distribution
   // make sure it is within the parameter domain.
   //-------------------------------------------------------------------------
-  int sample_normal(vec_t & sample, const size_t problem_size, const vec_t & mean, const matrix_t & MatrixRoot, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_pt rng)
+  int sample_normal(vec_t & sample, const size_t problem_size, const vec_t & mean, const matrix_t & MatrixRoot, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_t & rng)
   {
     vec_t sample_transformed;
     return sample_normal(sample, sample_transformed, problem_size, mean, MatrixRoot, lower_param_range, upper_param_range, rng);
   }
   
-  int sample_normal(vec_t & sample, vec_t & z, const size_t problem_size, const vec_t & mean, const matrix_t & MatrixRoot, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_pt rng)
+  int sample_normal(vec_t & sample, vec_t & z, const size_t problem_size, const vec_t & mean, const matrix_t & MatrixRoot, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_t & rng)
   {
 
     // Sample independent standard normal variables Z = N(0,1)
-    std::normal_distribution<double> std_normal(0.0, 1.0);
-    // vec_t z(problem_size);
     z.resize(problem_size); // param_transformed
-    
-    // try to sample within bounds
-    bool sample_in_range = false;
-    int attempts = 0;
+    standard_normals(rng, z.data(), problem_size);
 
-    // try using the normal distribution
-    while (!sample_in_range && attempts < 100)
-    {
+    sample.resize(problem_size);
+    matrix_vector_product(MatrixRoot, z.data(), sample.data());
+    for (size_t i = 0; i < problem_size; ++i) {
+      sample[i] = mean[i] + sample[i];
+    }
 
-      // sample a new solution
-      for (size_t i = 0; i < problem_size; ++i) {
-        z[i] = std_normal(*rng);
-      }
+    if (in_range(sample, lower_param_range, upper_param_range)) {
+      return 0;
+    }
+
+    return truncate_normal_sample(sample, z, problem_size, mean, MatrixRoot, 1.0, lower_param_range, upper_param_range, rng);
 
-      sample = mean + MatrixRoot.product(z);
-      boundary_repair(sample, lower_param_range, upper_param_range);
+  }
 
-      sample_in_range = in_range(sample, lower_param_range, upper_param_range);
-      attempts++;
+  int sample_normal_univariate(vec_t & sample, const size_t problem_size, const vec_t & mean, const vec_t & chol, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_t & rng)
+  {
 
-    }
+    // Sample independent standard normal variables Z = N(0,1)
+    vec_t z(problem_size);
+    standard_normals(rng, z.data(), problem_size);
 
-    // if that fails, fall back to uniform from the initial user-defined range
-    if (!sample_in_range) {
-      sample_uniform(sample, problem_size, lower_param_range, upper_param_range, rng);
+    // the coordinates are independent, so each is drawn from its own truncated normal
+    sample.resize(problem_size);
+    int number_of_redrawn_coordinates = 0;
+
+    for (size_t i = 0; i < problem_size; ++i)
+    {
+      sample[i] = mean[i] + chol[i]*z[i];
+
+      if (sample[i] < lower_param_range[i] || sample[i] > upper_param_range[i])
+      {
+        if (chol[i] > 0.0)
+        {
+          double a = (lower_param_range[i] - mean[i]) / chol[i];
+          double b = (upper_param_range[i] - mean[i]) / chol[i];
+          sample[i] = mean[i] + chol[i] * truncated_standard_normal(rng, a, b);
+        }
+
+        number_of_redrawn_coordinates++;
+      }
     }
 
-    return attempts;
+    // rounding might still put a coordinate just out of range
+    boundary_repair(sample, lower_param_range, upper_param_range);
+
+    return number_of_redrawn_coordinates;
 
   }
 
-  int sample_normal_univariate(vec_t & sample, const size_t problem_size, const vec_t & mean, const matrix_t & chol, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_pt rng)
+  // the blocks are independent, and each is sampled as in truncate_normal_sample,
+  // which leaves z as it is if the block is in range
+  int sample_normal_blocks(vec_t & sample, const size_t problem_size, const vec_t & mean, const std::vector<std::vector<size_t>> & blocks, const std::vector<matrix_t> & chol, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_t & rng)
   {
 
     // Sample independent standard normal variables Z = N(0,1)
-    std::normal_distribution<double> std_normal(0.0, 1.0);
+    vec_t z(problem_size);
+    standard_normals(rng, z.data(), problem_size);
+
     sample.resize(problem_size);
+    int number_of_redrawn_coordinates = 0;
+
+    for (size_t b = 0; b < blocks.size(); ++b)
+    {
+      const std::vector<size_t> & block = blocks[b];
+      const matrix_t & L = chol[b];
+
+      for (size_t i = 0; i < block.size(); ++i)
+      {
+        size_t p = block[i];
+
+        // the part of sample[p] fixed by the previous coordinates of the block
+        double offset = 0.0;
+        for (size_t j = 0; j < i; ++j) {
+          offset += L[i][j] * z[block[j]];
+        }
+        offset += mean[p];
 
-    // try to sample within bounds
-    bool sample_in_range = false;
-    int attempts = 0;
+        double diagonal = L[i][i];
+        sample[p] = offset + diagonal * z[p];
 
-    // try using the normal distribution
-    while (!sample_in_range && attempts < 100)
+        if (sample[p] < lower_param_range[p] || sample[p] > upper_param_range[p])
+        {
+          if (diagonal > 0.0)
+          {
+            z[p] = truncated_standard_normal(rng, (lower_param_range[p] - offset) / diagonal, (upper_param_range[p] - offset) / diagonal);
+            sample[p] = offset + diagonal * z[p];
+          }
+
+          number_of_redrawn_coordinates++;
+        }
+      }
+    }
+
+    // rounding (or a zero diagonal) might still put a coordinate just out of range
+    boundary_repair(sample, lower_param_range, upper_param_range);
+
+    return number_of_redrawn_coordinates;
+
+  }
+
+  int truncate_normal_sample(vec_t & sample, vec_t & z, const size_t problem_size, const vec_t & mean, const matrix_t & chol, double scale, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_t & rng)
+  {
+
+    sample.resize(problem_size);
+    int number_of_redrawn_coordinates = 0;
+
+    for (size_t i = 0; i < problem_size; ++i)
     {
 
-      // sample a new solution
-      for (size_t i = 0; i < problem_size; ++i) {
-        sample[i] = mean[i] + chol[i][i]*std_normal(*rng);
+      // the part of sample[i] fixed by the previous coordinates
+      double offset = 0.0;
+      for (size_t j = 0; j < i; ++j) {
+        offset += chol[i][j] * z[j];
       }
+      offset = mean[i] + scale * offset;
 
-      boundary_repair(sample, lower_param_range, upper_param_range);
+      double diagonal = scale * chol[i][i];
+      sample[i] = offset + diagonal * z[i];
 
-      sample_in_range = in_range(sample, lower_param_range, upper_param_range);
-      attempts++;
+      if (sample[i] < lower_param_range[i] || sample[i] > upper_param_range[i])
+      {
+        if (diagonal > 0.0)
+        {
+          z[i] = truncated_standard_normal(rng, (lower_param_range[i] - offset) / diagonal, (upper_param_range[i] - offset) / diagonal);
+          sample[i] = offset + diagonal * z[i];
+        }
 
-    }
-    // if that fails, fall back to uniform from the initial user-defined range
-    if (!sample_in_range) {
-      sample_uniform(sample, problem_size, lower_param_range, upper_param_range, rng);
-      std::cout << "Too many sample attempts. Sample uniform. (mathfunctions.cpp:105)" << std::endl;
+        number_of_redrawn_coordinates++;
+      }
     }
 
-    return attempts;
+    // rounding (or a zero diagonal) might still put a coordinate just out of range
+    boundary_repair(sample, lower_param_range, upper_param_range);
+
+    return number_of_redrawn_coordinates;
 
   }
   
   // sample the solution from a uniform distribution
   //-------------------------------------------------------------------------
-  void sample_uniform(vec_t & sample, const size_t problem_size, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_pt rng)
+  void sample_uniform(vec_t & sample, const size_t problem_size, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_t & rng)
   {
     
     // resize the parameter vector (in case it is larger)
@@ -206,7 +279,7 @@ namespace hillvallea
     for (size_t i = 0; i < problem_size; ++i)
     {
      
-      double r = unif(*rng);
+      double r = unif(rng);
       sample[i] = r * (upper_param_range[i] - lower_param_range[i]) + lower_param_range[i];
       
     }
@@ -214,6 +287,38 @@ namespace hillvallea
   }
   
   
+  double ams_shrink_factor(const vec_t & x, const double ams_factor, const vec_t & ams_direction, const vec_t & lower_param_range, const vec_t & upper_param_range)
+  {
+
+    // the largest step along the shift that stays in range
+    double max_step = 1e308;
+
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+      double shift = ams_factor * ams_direction[i];
+
+      if (shift > 0.0) {
+        max_step = std::min(max_step, (upper_param_range[i] - x[i]) / shift);
+      }
+
+      if (shift < 0.0) {
+        max_step = std::min(max_step, (lower_param_range[i] - x[i]) / shift);
+      }
+    }
+
+    double shrink_factor = 2.0;
+    for (int attempts = 0; attempts < 100; ++attempts)
+    {
+      if (shrink_factor <= max_step) {
+        return shrink_factor;
+      }
+
+      shrink_factor *= 0.5;
+    }
+
+    return 0.0;
+  }
+
   // check if a solution is within the parameter bounds
   //-------------------------------------------------------------------------------------
   bool in_range(const vec_t & sample, const vec_t & lower_param_range, const vec_t & upper_param_range)
@@ -360,210 +465,31 @@ namespace hillvallea
   }
 
 
-  /**
-   * BLAS subroutine.
-   */
-  int blasDSWAP(int n, double *dx, int incx, double *dy, int incy)
-  {
-    double dtmp;
-    
-    if (n > 0)
-    {
-      incx *= sizeof(double);
-      incy *= sizeof(double);
-      
-      dtmp = (*dx);
-      *dx = (*dy);
-      *dy = dtmp;
-      
-      while ((--n) > 0)
-      {
-        dx = (double *)((char *)dx + incx);
-        dy = (double *)((char *)dy + incy);
-        dtmp = (*dx); *dx = (*dy); *dy = dtmp;
-      }
-    }
-    
-    return(0);
-  }
-  
-  /**
-   * BLAS subroutine.
-   */
-  int blasDAXPY(int n, double da, double *dx, int incx, double *dy, int incy)
-  {
-    double dtmp0, dtmp, *dx0, *dy0;
-    
-    if (n > 0 && da != 0.)
-    {
-      incx *= sizeof(double);
-      incy *= sizeof(double);
-      *dy += da * (*dx);
-      
-      if ((n & 1) == 0)
-      {
-        dx = (double *)((char *)dx + incx);
-        dy = (double *)((char *)dy + incy);
-        *dy += da * (*dx);
-        --n;
-      }
-      n = n >> 1;
-      while (n > 0)
-      {
-        dy0 = (double *)((char *)dy + incy);
-        dy = (double *)((char *)dy0 + incy);
-        dtmp0 = (*dy0);
-        dtmp = (*dy);
-        dx0 = (double *)((char *)dx + incx);
-        dx = (double *)((char *)dx0 + incx);
-        *dy0 = dtmp0 + da * (*dx0);
-        *dy = dtmp + da * (*dx);
-        --n;
-      }
-    }
-    
-    return(0);
-  }
-  
-  /**
-   * BLAS subroutine.
-   */
-  void blasDSCAL(int n, double sa, double x[], int incx)
-  {
-    int i, ix, m;
-    
-    if (n <= 0)
-    {
-    }
-    else if (incx == 1)
-    {
-      m = n % 5;
-      
-      for (i = 0; i < m; i++)
-      {
-        x[i] = sa * x[i];
-      }
-      
-      for (i = m; i < n; i = i + 5)
-      {
-        x[i] = sa * x[i];
-        x[i + 1] = sa * x[i + 1];
-        x[i + 2] = sa * x[i + 2];
-        x[i + 3] = sa * x[i + 3];
-        x[i + 4] = sa * x[i + 4];
-      }
-    }
-    else
-    {
-      if (0 <= incx)
-      {
-        ix = 0;
-      }
-      else
-      {
-        ix = (-n + 1) * incx;
-      }
-      
-      for (i = 0; i < n; i++)
-      {
-        x[ix] = sa * x[ix];
-        ix = ix + incx;
-      }
-    }
-  }
-  
-  /**
-   * LINPACK subroutine.
-   */
-  int linpackDCHDC(double a[], int lda, int p, double work[], int ipvt[])
-  {
-    int    info, j, jp, k, l, maxl, pl, pu;
-    double maxdia, temp;
-    
-    pl = 1;
-    pu = 0;
-    info = p;
-    for (k = 1; k <= p; k++)
-    {
-      maxdia = a[k - 1 + (k - 1)*lda];
-      maxl = k;
-      if (pl <= k && k < pu)
-      {
-        for (l = k + 1; l <= pu; l++)
-        {
-          if (maxdia < a[l - 1 + (l - 1)*lda])
-          {
-            maxdia = a[l - 1 + (l - 1)*lda];
-            maxl = l;
-          }
-        }
-      }
-      
-      if (maxdia <= 0.0)
-      {
-        info = k - 1;
-        
-        return(info);
-      }
-      
-      if (k != maxl)
-      {
-        blasDSWAP(k - 1, a + 0 + (k - 1)*lda, 1, a + 0 + (maxl - 1)*lda, 1);
-        
-        a[maxl - 1 + (maxl - 1)*lda] = a[k - 1 + (k - 1)*lda];
-        a[k - 1 + (k - 1)*lda] = maxdia;
-        jp = ipvt[maxl - 1];
-        ipvt[maxl - 1] = ipvt[k - 1];
-        ipvt[k - 1] = jp;
-      }
-      work[k - 1] = sqrt(a[k - 1 + (k - 1)*lda]);
-      a[k - 1 + (k - 1)*lda] = work[k - 1];
-      
-      for (j = k + 1; j <= p; j++)
-      {
-        if (k != maxl)
-        {
-          if (j < maxl)
-          {
-            temp = a[k - 1 + (j - 1)*lda];
-            a[k - 1 + (j - 1)*lda] = a[j - 1 + (maxl - 1)*lda];
-            a[j - 1 + (maxl - 1)*lda] = temp;
-          }
-          else if (maxl < j)
-          {
-            temp = a[k - 1 + (j - 1)*lda];
-            a[k - 1 + (j - 1)*lda] = a[maxl - 1 + (j - 1)*lda];
-            a[maxl - 1 + (j - 1)*lda] = temp;
-          }
-        }
-        a[k - 1 + (j - 1)*lda] = a[k - 1 + (j - 1)*lda] / work[k - 1];
-        work[j - 1] = a[k - 1 + (j - 1)*lda];
-        temp = -a[k - 1 + (j - 1)*lda];
-        
-        blasDAXPY(j - k, temp, work + k, 1, a + k + (j - 1)*lda, 1);
-      }
-    }
-    
-    return(info);
-  }
-  
-  /**
-   * Computes the lower-triangle Cholesky Decomposition
-   * of a square, symmetric and positive-definite matrix.
-   * Subroutines from LINPACK and BLAS are used.
-   */
-   // Cholesky decomposition
-   //---------------------------------------------------------------------------
+  // Cholesky decomposition
+  //---------------------------------------------------------------------------
+  // The factor is computed in the buffer of chol (cholesky_lower). If cov is not
+  // positive definite, chol is set to the square root of its diagonal.
+  // cov and chol must be different matrices.
   void choleskyDecomposition(const matrix_t & cov, matrix_t & chol)
   {
 
     assert(cov.rows() == cov.cols());
-    int n = (int)cov.rows();
+    assert(&chol != &cov);
+    size_t n = cov.rows();
 
-    double **cholesky_factor_lower_triangle;
-    cholesky_factor_lower_triangle = choleskyDecomposition(cov.toArray(), n);
+    chol.resize(n, n);
+    for (size_t i = 0; i < n; ++i) {
+      std::copy(cov[i], cov[i] + i + 1, chol[i]);
+    }
 
-    chol.setRaw(cholesky_factor_lower_triangle, n, n);
+    if (!cholesky_lower(chol)) /* Matrix is not positive definite */
+    {
+      for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+          chol[i][j] = i != j ? 0.0 : sqrt(cov[i][i]);
+        }
+      }
+    }
   }
 
   void choleskyDecomposition_univariate(const matrix_t & cov, matrix_t & chol)
@@ -579,135 +505,75 @@ namespace hillvallea
 
   }
 
+  void choleskyDecomposition_univariate(const vec_t & variances, vec_t & chol)
+  {
+    chol.resize(variances.size());
+
+    for (size_t i = 0; i < variances.size(); ++i)
+      chol[i] = sqrt(variances[i]);
+  }
 
-  double **choleskyDecomposition(double **matrix, int n)
+  // as in matrixLowerTriangularInverse (LINPACK DTRDI), only the entries after
+  // the last zero on the diagonal are inverted. The others are left as they are.
+  void matrixDiagonalInverse(const vec_t & diagonal, vec_t & inverse_diagonal)
   {
-    int     i, j, k, info, *ipvt;
-    double *a, *work, **result;
-    
-    a = (double *)Malloc(n*n*sizeof(double));
-    work = (double *)Malloc(n*sizeof(double));
-    ipvt = (int *)Malloc(n*sizeof(int));
-    
-    k = 0;
-    for (i = 0; i < n; i++)
-    {
-      for (j = 0; j < n; j++)
-      {
-        a[k] = matrix[i][j];
-        k++;
-      }
-      ipvt[i] = 0;
-    }
-    
-    info = linpackDCHDC(a, n, n, work, ipvt);
-    
-    result = matrixNew(n, n);
-    if (info != n) /* Matrix is not positive definite */
+    size_t n = diagonal.size();
+    inverse_diagonal = diagonal;
+
+    size_t first = 0;
+    for (size_t k = n; k-- > 0; )
     {
-      k = 0;
-      for (i = 0; i < n; i++)
-      {
-        for (j = 0; j < n; j++)
-        {
-          result[i][j] = i != j ? 0.0 : sqrt(matrix[i][j]);
-          k++;
-        }
+      if (diagonal[k] == 0.0) {
+        first = k + 1;
+        break;
       }
     }
-    else
-    {
-      k = 0;
-      for (i = 0; i < n; i++)
-      {
-        for (j = 0; j < n; j++)
-        {
-          result[i][j] = i < j ? 0.0 : a[k];
-          k++;
-        }
-      }
+
+    for (size_t k = first; k < n; ++k) {
+      inverse_diagonal[k] = 1.0 / diagonal[k];
     }
-    
-    free(ipvt);
-    free(work);
-    free(a);
-    
-    return(result);
   }
-  
+
   /**
-   * LINPACK subroutine.
+   * Computes the inverse of a matrix that is of
+   * lower triangular form, in the buffer of inverse_chol.
+   * The transpose is stored, so that the columns are
+   * contiguous, inverted, and transposed back.
    */
-  int linpackDTRDI(double t[], int ldt, int n)
+  void matrixLowerTriangularInverse(const matrix_t & chol, matrix_t & inverse_chol)
   {
-    int    j, k, info;
-    double temp;
-    
-    info = 0;
-    for (k = n; 1 <= k; k--)
+    assert(chol.rows() == chol.cols());
+    size_t n = chol.rows();
+
+    if (&inverse_chol != &chol)
     {
-      if (t[k - 1 + (k - 1)*ldt] == 0.0)
-      {
-        info = k;
-        break;
-      }
-      
-      t[k - 1 + (k - 1)*ldt] = 1.0 / t[k - 1 + (k - 1)*ldt];
-      temp = -t[k - 1 + (k - 1)*ldt];
-      
-      if (k != n)
-      {
-        blasDSCAL(n - k, temp, t + k + (k - 1)*ldt, 1);
-      }
-      
-      for (j = 1; j <= k - 1; j++)
-      {
-        temp = t[k - 1 + (j - 1)*ldt];
-        t[k - 1 + (j - 1)*ldt] = 0.0;
-        blasDAXPY(n - k + 1, temp, t + k - 1 + (k - 1)*ldt, 1, t + k - 1 + (j - 1)*ldt, 1);
+      inverse_chol.resize(n, n);
+      for (size_t i = 0; i < n; i++) {
+        for (size_t j = i; j < n; j++) {
+          inverse_chol[i][j] = chol[j][i];
+        }
       }
     }
-    
-    return(info);
-  }
-  
-  /**
-   * Computes the inverse of a matrix that is of
-   * lower triangular form.
-   */
-  double **matrixLowerTriangularInverse(double **matrix, int n)
-  {
-    int     i, j, k;
-    double *t, **result;
-    
-    t = (double *)Malloc(n*n*sizeof(double));
-    
-    k = 0;
-    for (i = 0; i < n; i++)
+    else
     {
-      for (j = 0; j < n; j++)
-      {
-        t[k] = matrix[j][i];
-        k++;
+      for (size_t i = 0; i < n; i++) {
+        for (size_t j = i + 1; j < n; j++) {
+          inverse_chol[i][j] = inverse_chol[j][i];
+        }
       }
     }
-    
-    linpackDTRDI(t, n, n);
-    
-    result = matrixNew(n, n);
-    k = 0;
-    for (i = 0; i < n; i++)
+
+    lower_triangular_inverse_transposed(inverse_chol);
+
+    for (size_t i = 0; i < n; i++)
     {
-      for (j = 0; j < n; j++)
+      for (size_t j = i; j < n; j++)
       {
-        result[j][i] = i > j ? 0.0 : t[k];
-        k++;
+        double value = inverse_chol[i][j];
+        inverse_chol[i][j] = (i == j) ? value : 0.0;
+        inverse_chol[j][i] = value;
       }
     }
-    
-    free(t);
-    
-    return(result);
   }
 
   // end BLAS / LINPACK library functions
@@ -757,9 +623,27 @@ namespace hillvallea
       }
     }
     
+    // the points that are left are kept contiguously, in the order of indices_left,
+    // so that the distances to the last selected point are computed in one sweep.
+    size_t ld = aligned_leading_dimension(number_of_dimensions);
+    aligned_vec_t points_left(number_of_points * ld);
+    for (size_t i = 0; i < number_of_points; i++) {
+      std::copy(points[i].begin(), points[i].end(), &points_left[i * ld]);
+    }
+    vec_t squared_distances_to_last(number_of_points);
+
+    // replaces the point at index by the last point that is left
+    auto remove_point_left = [&](size_t index, size_t number_left)
+    {
+      if (index != number_left - 1) {
+        std::copy(&points_left[(number_left - 1) * ld], &points_left[(number_left - 1) * ld] + number_of_dimensions, &points_left[index * ld]);
+      }
+    };
+
     size_t number_selected_so_far = 0;
     result[number_selected_so_far] = indices_left[index_of_farthest];
     indices_left[index_of_farthest] = indices_left[number_of_points - number_selected_so_far - 1];
+    remove_point_left(index_of_farthest, number_of_points - number_selected_so_far);
     number_selected_so_far++;
     
     /* Then select the rest of the solutions: maximum minimum
@@ -767,8 +651,9 @@ namespace hillvallea
     
     vec_t nn_distances(number_of_points, 0.0);
     
+    squared_distances(points[result[number_selected_so_far - 1]].data(), points_left.data(), number_of_points - number_selected_so_far, number_of_dimensions, ld, squared_distances_to_last.data());
     for (size_t i = 0; i < number_of_points - number_selected_so_far; i++) {
-      nn_distances[i] = (points[indices_left[i]] - points[result[number_selected_so_far - 1]]).norm();
+      nn_distances[i] = sqrt(squared_distances_to_last[i]);
     }
     
     while (number_selected_so_far < number_to_select)
@@ -787,12 +672,15 @@ namespace hillvallea
       result[number_selected_so_far] = indices_left[index_of_farthest];
       indices_left[index_of_farthest] = indices_left[number_of_points - number_selected_so_far - 1];
       nn_distances[index_of_farthest] = nn_distances[number_of_points - number_selected_so_far - 1];
+      remove_point_left(index_of_farthest, number_of_points - number_selected_so_far);
       number_selected_so_far++;
       
+      squared_distances(points[result[number_selected_so_far - 1]].data(), points_left.data(), number_of_points - number_selected_so_far, number_of_dimensions, ld, squared_distances_to_last.data());
+
       double value;
       for (size_t i = 0; i < number_of_points - number_selected_so_far; i++)
       {
-        value = (points[indices_left[i]] - points[result[number_selected_so_far - 1]]).norm();
+        value = sqrt(squared_distances_to_last[i]);
         if (value < nn_distances[i]) {
           nn_distances[i] = value;
         }
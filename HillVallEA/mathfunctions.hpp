@@ -25,38 +25,48 @@ namespace hillvallea
   double normpdf_diagonal(const vec_t & mean, const vec_t & cov_diagonal, const vec_t & x);           // uses diag(cov) only
   double normcdf(const double x);
   
-  // sample parameters using normal distribution
-  // returns the number of trials before an in-range sample is found.
-  // on too many fails, sample uniform.
+  // sample parameters using normal distribution, truncated to the parameter range.
+  // returns the number of coordinates that fell out of range and were redrawn,
+  // i.e., 0 if the first (untruncated) sample is in range.
   //----------------------------------------------
-  int sample_normal(vec_t & sample, const size_t problem_size, const vec_t & mean, const matrix_t & chol, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_pt rng);
-  int sample_normal_univariate(vec_t & sample, const size_t problem_size, const vec_t & mean, const matrix_t & chol, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_pt rng);
-  int sample_normal(vec_t & sample, vec_t & sample_transformed, const size_t problem_size, const vec_t & mean, const matrix_t & chol, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_pt rng);
+  int sample_normal(vec_t & sample, const size_t problem_size, const vec_t & mean, const matrix_t & chol, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_t & rng);
+  int sample_normal_univariate(vec_t & sample, const size_t problem_size, const vec_t & mean, const vec_t & chol, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_t & rng);
+  int sample_normal_blocks(vec_t & sample, const size_t problem_size, const vec_t & mean, const std::vector<std::vector<size_t>> & blocks, const std::vector<matrix_t> & chol, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_t & rng);
+  int sample_normal(vec_t & sample, vec_t & sample_transformed, const size_t problem_size, const vec_t & mean, const matrix_t & chol, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_t & rng);
 
-  void sample_uniform(vec_t & sample, const size_t problem_size, const vec_t & lower_user_range, const vec_t & upper_user_range,  rng_pt rng);
+  // bring sample = mean + scale * chol * z in range, with chol lower triangular.
+  // Coordinate by coordinate, z[i] is redrawn from the normal truncated to the values
+  // that put sample[i] in range, given z[0..i-1]. Coordinates that are in range keep
+  // their z. Exact for diagonal chol, and the sequential (GHK) approximation of the
+  // truncated multivariate normal otherwise. Returns the number of redrawn coordinates.
+  //----------------------------------------------
+  int truncate_normal_sample(vec_t & sample, vec_t & z, const size_t problem_size, const vec_t & mean, const matrix_t & chol, double scale, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_t & rng);
+
+  void sample_uniform(vec_t & sample, const size_t problem_size, const vec_t & lower_user_range, const vec_t & upper_user_range,  rng_t & rng);
   
+  // largest shrink factor s in {2, 1, 1/2, ..., 2^-98} for which x + s * ams_factor * ams_direction
+  // is in range, or 0 if there is none (the shrinking of the Anticipated Mean Shift)
+  //-----------------------------------------
+  double ams_shrink_factor(const vec_t & x, const double ams_factor, const vec_t & ams_direction, const vec_t & lower_param_range, const vec_t & upper_param_range);
+
   // check if the parameter is in range
   //-----------------------------------------
   bool in_range(const vec_t & sample, const vec_t & lower_param_range, const vec_t & upper_param_range);
   bool boundary_repair(vec_t & sample, const vec_t & lower_param_range, const vec_t & upper_param_range);
 
-  // Cholesky decomposition
-  // based on BLAS / LINPACK library functions
+  // Cholesky decomposition and triangular inverse
+  // in the buffers of the given matrices, see linalg.hpp
   //-----------------------------------------
   void choleskyDecomposition(const matrix_t & cov, matrix_t & chol);
   void choleskyDecomposition_univariate(const matrix_t & cov, matrix_t & chol);
+  void choleskyDecomposition_univariate(const vec_t & variances, vec_t & chol);  // diagonals only
+  void matrixDiagonalInverse(const vec_t & diagonal, vec_t & inverse_diagonal);   // diagonals only, as matrixLowerTriangularInverse
   void *Malloc(long size);
   double **matrixNew(int n, int m);
   double vectorDotProduct(const double *vector0, const double *vector1, int n0);
   double *matrixVectorMultiplication(const double **matrix, const double *vector, int n0, int n1);
   double **matrixMatrixMultiplication(const double **matrix0, const double **matrix1, int n0, int n1, int n2);
-  int blasDSWAP(int n, double *dx, int incx, double *dy, int incy);
-  int blasDAXPY(int n, double da, double *dx, int incx, double *dy, int incy);
-  void blasDSCAL(int n, double sa, double x[], int incx);
-  int linpackDCHDC(double a[], int lda, int p, double work[], int ipvt[]);
-  double **choleskyDecomposition(double **matrix, int n);
-  int linpackDTRDI(double t[], int ldt, int n);
-  double **matrixLowerTriangularInverse(double **matrix, int n);
+  void matrixLowerTriangularInverse(const matrix_t & chol, matrix_t & inverse_chol);
   
   
   /**
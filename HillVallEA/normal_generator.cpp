@@ -0,0 +1,238 @@
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+
+*/
+
+#include "normal_generator.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+namespace hillvallea
+{
+
+  // The 128 layers are bounded by x[0] > x[1] = r > ... > x[128] = 0, all with area v.
+  // Layer 0 is the base strip plus the tail beyond r; x[0] = v / f(r) is its virtual width.
+  // A sample in layer i is accepted outright if it is below x[i+1], i.e., if the uniform
+  // position is below ratio[i] = x[i+1] / x[i].
+  //-------------------------------------------------------------------------------
+  static const size_t ziggurat_layers = 128;
+  static const double ziggurat_r = 3.442619855899;
+  static const double ziggurat_v = 9.91256303526217e-3;
+
+  struct ziggurat_tables_t
+  {
+    double x[ziggurat_layers + 1];
+    double y[ziggurat_layers + 1]; // y[i] = f(x[i]) = exp(-x[i]^2 / 2)
+    double ratio[ziggurat_layers];
+  };
+
+  static const ziggurat_tables_t & ziggurat_tables()
+  {
+    static const ziggurat_tables_t tables = []()
+    {
+      ziggurat_tables_t t;
+
+      t.x[0] = ziggurat_v / exp(-0.5 * ziggurat_r * ziggurat_r);
+      t.x[1] = ziggurat_r;
+
+      for (size_t i = 1; i < ziggurat_layers - 1; ++i) {
+        t.x[i + 1] = sqrt(-2.0 * log(ziggurat_v / t.x[i] + exp(-0.5 * t.x[i] * t.x[i])));
+      }
+
+      t.x[ziggurat_layers] = 0.0;
+
+      for (size_t i = 0; i <= ziggurat_layers; ++i) {
+        t.y[i] = exp(-0.5 * t.x[i] * t.x[i]);
+      }
+
+      for (size_t i = 0; i < ziggurat_layers; ++i) {
+        t.ratio[i] = t.x[i + 1] / t.x[i];
+      }
+
+      return t;
+    }();
+
+    return tables;
+  }
+
+  // 64 random bits
+  static inline uint64_t random_word(rng_t & rng)
+  {
+    return rng.next_word();
+  }
+
+  // uniform in [0,1) from the upper 52 bits of w
+  static inline double word_to_uniform(uint64_t w)
+  {
+    uint64_t bits = (w >> 12) | 0x3FF0000000000000ULL;
+    double u;
+    std::memcpy(&u, &bits, sizeof(double));
+    return u - 1.0;
+  }
+
+  // uniform in (0,1), for the logarithms of the tail
+  static inline double word_to_open_uniform(uint64_t w)
+  {
+    return ((double) (w >> 12) + 0.5) * (1.0 / 4503599627370496.0);
+  }
+
+  // the sample of word w if it is inside its layer. Fills in the layer and position.
+  static inline double ziggurat_candidate(const ziggurat_tables_t & t, uint64_t w, size_t & layer, double & u)
+  {
+    layer = (size_t) (w & (ziggurat_layers - 1));
+    u = word_to_uniform(w);
+    double x = u * t.x[layer];
+    return (w & ziggurat_layers) ? -x : x;
+  }
+
+  // draws until a sample is accepted, starting with word w
+  static double ziggurat_redraw(rng_t & rng, const ziggurat_tables_t & t, uint64_t w)
+  {
+    for (;;)
+    {
+      size_t layer;
+      double u;
+      double x = ziggurat_candidate(t, w, layer, u);
+      bool negative = (w & ziggurat_layers) != 0;
+
+      if (u < t.ratio[layer]) {
+        return x;
+      }
+
+      if (layer == 0)
+      {
+        // the tail beyond r (Marsaglia, 1964)
+        double tail, y;
+        do
+        {
+          tail = -log(word_to_open_uniform(random_word(rng))) / ziggurat_r;
+          y = -log(word_to_open_uniform(random_word(rng)));
+        } while (y + y < tail * tail);
+
+        return negative ? -(ziggurat_r + tail) : ziggurat_r + tail;
+      }
+
+      // the wedge between the layer and the density
+      double y = t.y[layer] + word_to_uniform(random_word(rng)) * (t.y[layer + 1] - t.y[layer]);
+      if (y < exp(-0.5 * x * x)) {
+        return x;
+      }
+
+      w = random_word(rng);
+    }
+  }
+
+  void standard_normals(rng_t & rng, double * out, size_t n)
+  {
+    const ziggurat_tables_t & t = ziggurat_tables();
+
+    const size_t chunk = 256;
+    uint64_t words[chunk];
+
+    for (size_t k0 = 0; k0 < n; k0 += chunk)
+    {
+      size_t kb = std::min(chunk, n - k0);
+      double * o = out + k0;
+
+      rng.generate(words, kb);
+
+      // accept all samples inside their layer
+      for (size_t k = 0; k < kb; ++k)
+      {
+        size_t layer;
+        double u;
+        o[k] = ziggurat_candidate(t, words[k], layer, u);
+      }
+
+      // redraw the others
+      for (size_t k = 0; k < kb; ++k)
+      {
+        if (word_to_uniform(words[k]) >= t.ratio[words[k] & (ziggurat_layers - 1)]) {
+          o[k] = ziggurat_redraw(rng, t, words[k]);
+        }
+      }
+    }
+  }
+
+  double standard_normal(rng_t & rng)
+  {
+    double z;
+    standard_normals(rng, &z, 1);
+    return z;
+  }
+
+  // truncated to [a,b] with a >= 0
+  static double truncated_standard_normal_tail(rng_t & rng, double a, double b)
+  {
+    // the mass lies within about 1/a of a, which rounds to a itself
+    if (a > 1e8) {
+      return a;
+    }
+
+    // optimal rate of the exponential proposal, and Robert's rule for when it
+    // beats the uniform proposal on [a,b]
+    double rate = 0.5 * (a + sqrt(a * a + 4.0));
+    bool exponential = (b - a) > (2.0 / (a + sqrt(a * a + 4.0))) * exp(0.25 * (a * a - a * sqrt(a * a + 4.0)) + 0.5);
+
+    for (;;)
+    {
+      if (exponential)
+      {
+        double z = a - log(word_to_open_uniform(random_word(rng))) / rate;
+        if (z <= b && word_to_uniform(random_word(rng)) <= exp(-0.5 * (z - rate) * (z - rate))) {
+          return z;
+        }
+      }
+      else
+      {
+        double z = a + (b - a) * word_to_uniform(random_word(rng));
+        if (word_to_uniform(random_word(rng)) <= exp(0.5 * (a * a - z * z))) {
+          return z;
+        }
+      }
+    }
+  }
+
+  double truncated_standard_normal(rng_t & rng, double a, double b)
+  {
+    if (!(a < b)) {
+      return a;
+    }
+
+    if (a >= 0.0) {
+      return truncated_standard_normal_tail(rng, a, b);
+    }
+
+    if (b <= 0.0) {
+      return -truncated_standard_normal_tail(rng, -b, -a);
+    }
+
+    // the interval contains 0
+    if (b - a >= sqrt(2.0 * PI))
+    {
+      for (;;)
+      {
+        double z = standard_normal(rng);
+        if (z >= a && z <= b) {
+          return z;
+        }
+      }
+    }
+
+    for (;;)
+    {
+      double z = a + (b - a) * word_to_uniform(random_word(rng));
+      if (word_to_uniform(random_word(rng)) <= exp(-0.5 * z * z)) {
+        return z;
+      }
+    }
+  }
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+*/
+
+#include "hillvallea_internal.hpp"
+
+namespace hillvallea
+{
+
+  // Bulk standard normal generator
+  // Ziggurat method (Marsaglia & Tsang, 2000) with 128 layers. Each sample takes one
+  // 64-bit word: 7 bits select the layer, 1 bit the sign, and 52 bits the position in
+  // the layer. A buffer is filled in two passes: a branch-free (vectorizable) pass
+  // that accepts the samples inside their layer (about 99%), and a pass that redraws
+  // the few others in the wedges or the tail.
+  //-------------------------------------------------------------------------------
+  void standard_normals(rng_t & rng, double * out, size_t n);
+  double standard_normal(rng_t & rng);
+
+  // Truncated standard normal generator
+  // Exact sample of the standard normal truncated to [a,b], a < b, by the rejection
+  // samplers of Robert (1995): from the normal itself for wide intervals around 0,
+  // from a translated exponential in the tails, and from the uniform otherwise.
+  // The acceptance rate is bounded away from zero for every interval.
+  //-------------------------------------------------------------------------------
+  double truncated_standard_normal(rng_t & rng, double a, double b);
+
+}
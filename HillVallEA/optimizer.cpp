@@ -16,6 +16,8 @@ github.com/SCMaree/HillVallEA
 #include "iamalgam.hpp"
 #include "iamalgam_univariate.hpp"
 #include "cmsaes.hpp"
+#include "lmmaes.hpp"
+#include "amalgam_block.hpp"
 
 hillvallea::optimizer_pt hillvallea::init_optimizer(const int local_optimizer_index, const size_t number_of_parameters, const vec_t & lower_param_bounds, const vec_t & upper_param_bounds, double init_univariate_bandwidth, fitness_pt fitness_function, rng_pt rng)
 {
@@ -25,9 +27,11 @@ hillvallea::optimizer_pt hillvallea::init_optimizer(const int local_optimizer_in
   {
     case 0: return std::make_shared<amalgam_t>(number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, rng); break;
     case 1: return std::make_shared<amalgam_univariate_t>(number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, rng); break;
+    case 2: return std::make_shared<amalgam_block_t>(number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, rng); break;
     case 10: return std::make_shared<cmsaes_t>(number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, rng); break;
     case 20: return std::make_shared<iamalgam_t>(number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, rng); break;
     case 21: return std::make_shared<iamalgam_univariate_t>(number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, rng); break;
+    case 30: return std::make_shared<lmmaes_t>(number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, rng); break;
     default: return std::make_shared<amalgam_t>(number_of_parameters, lower_param_bounds, upper_param_bounds, init_univariate_bandwidth, fitness_function, rng); break;
   }
 
@@ -52,11 +56,22 @@ hillvallea::optimizer_t::optimizer_t(const size_t number_of_parameters, const ve
   maximum_no_improvement_stretch = 1000000;
   param_std_tolerance = 0;
   fitness_std_tolerance = 0;
+  number_of_drawn_samples = 0;
+  number_of_rejected_samples = 0;
 
 }
 
 hillvallea::optimizer_t::~optimizer_t() {}
 
+double hillvallea::optimizer_t::rejection_rate() const
+{
+  if (number_of_drawn_samples == 0) {
+    return 0.0;
+  }
+
+  return (double) number_of_rejected_samples / (double) number_of_drawn_samples;
+}
+
  // Initialization
  //---------------------------------------------------------------------------------
 void hillvallea::optimizer_t::initialize_from_population(population_pt pop)
@@ -44,7 +44,7 @@ namespace hillvallea
     vec_t  lower_param_bounds, upper_param_bounds;
     fitness_pt fitness_function;
     int number_of_generations;
-    std::shared_ptr<std::mt19937> rng;
+    rng_pt rng;
     population_pt pop;
     solution_t best;
     vec_t average_fitness_history;
@@ -54,6 +54,13 @@ namespace hillvallea
     double param_std_tolerance;
     double fitness_std_tolerance;
 
+    // Sampling statistics: the number of sampled solutions, and the number of those that
+    // fell out of the parameter range and were redrawn from the truncated normal
+    //--------------------------------------------------------------------------------
+    size_t number_of_drawn_samples;
+    size_t number_of_rejected_samples;
+    double rejection_rate() const;
+
   };
 
   // initialized optimizers of different types
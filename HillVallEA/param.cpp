@@ -11,6 +11,7 @@ github.com/SCMaree/HillVallEA
 
 #include "param.hpp"
 #include "mathfunctions.hpp"
+#include "linalg.hpp"
 
 namespace hillvallea
 {
@@ -220,138 +221,6 @@ namespace hillvallea
   
   
   
-  // param = param - param
-  vec_t operator-(const vec_t &pl, const vec_t &pr)
-  {
-    
-    assert (pl.size() == pr.size());
-    
-    vec_t r(pl.size(),0.0);
-    
-    for(size_t i = 0; i < pl.size(); i++) {
-      r[i] = pl[i] - pr[i];
-    }
-    
-    return r;
-    
-  }
-  
-  // vec = vec - double
-  vec_t operator-(const vec_t &p, const double &v)
-  {
-    
-    vec_t r(p.size(),0.0);
-    
-    for(size_t i = 0; i < p.size(); i++) {
-      r[i] = p[i] - v;
-    }
-    
-    return r;
-    
-  }
-  
-  // vec = double - vec
-  vec_t operator-(const double &v, const vec_t &p)
-  {
-    
-    vec_t r(p.size(),0.0);
-    
-    for(size_t i = 0; i < p.size(); i++) {
-      r[i] = v - p[i];
-    }
-    
-    return r;
-    
-  }
-  
-  
-  // param = param + param
-  vec_t operator+(const vec_t &pl, const vec_t &pr)
-  {
-    
-    assert (pl.size() == pr.size());
-    
-    vec_t r(pl.size(),0.0);
-    
-    for(size_t i = 0; i < pl.size(); i++) {
-      r[i] = pl[i] + pr[i];
-    }
-    
-    return r;
-    
-  }
-  
-  // param = param + double
-  vec_t operator+(const vec_t &p, const double &v)
-  {
-    
-    vec_t r(p.size(),0.0);
-    
-    for(size_t i = 0; i < p.size(); i++) {
-      r[i] = p[i] + v;
-    }
-    
-    return r;
-    
-  }
-  
-  // param = double + param
-  vec_t operator+(const double &v, const vec_t &p)
-  {
-    
-    vec_t r(p.size(),0.0);
-    
-    for(size_t i = 0; i < p.size(); i++) {
-      r[i] = v + p[i];
-    }
-    
-    return r;
-    
-  }
-  
-  // param = double * param;
-  vec_t operator*(const double &v, const vec_t &p)
-  {
-    
-    vec_t r(p.size(),0.0);
-    
-    for(size_t i = 0; i < p.size(); i++) {
-      r[i] = v * p[i];
-    }
-    
-    return r;
-    
-  }
-  
-  // param = param * double
-  vec_t operator*(const vec_t &p, const double &v)
-  {
-    
-    vec_t r(p.size(),0.0);
-    
-    for(size_t i = 0; i < p.size(); i++) {
-      r[i] = p[i] * v;
-    }
-    
-    return r;
-    
-  }
-  
-  // param = param / double
-  vec_t operator/(const vec_t &p, const double &v)
-  {
-    
-    vec_t r(p.size(),0.0);
-    
-    for(size_t i = 0; i < p.size(); i++) {
-      r[i] = p[i] / v;
-    }
-    
-    return r;
-    
-  }
-  
-  
   // Assignment operators
   //----------------------------------------------------------------------
   vec_t & vec_t::operator=(const vec_t& pr) {
@@ -450,22 +319,22 @@ namespace hillvallea
   //----------------------------------------------------------------------------
   // constructors
   matrix_t::matrix_t() {
-    raw = NULL;
     raw_rows = 0;
     raw_cols = 0;
+    ld = 0;
   }
   
   matrix_t::matrix_t(const size_t &n, const size_t &m) {
-    raw = NULL;
     raw_rows = 0;
     raw_cols = 0;
+    ld = 0;
     resize(n,m);
   }
   
   matrix_t::matrix_t(const size_t &n, const size_t &m, const double &v) {
-    raw = NULL; 
     raw_rows = 0;
     raw_cols = 0;
+    ld = 0;
     resize(n,m);
     fill(v);
   }
@@ -473,31 +342,21 @@ namespace hillvallea
   // copy constructor
   matrix_t::matrix_t(const matrix_t &m)
   {
-    raw = NULL;
-    raw_rows = m.raw_rows;
-    raw_cols = m.raw_cols;
-    raw = matrixNew((int)raw_rows, (int)raw_cols);
-
-    for (size_t i = 0; i < rows(); ++i)
-      for (size_t j = 0; j < cols(); ++j)
-        raw[i][j] = m[i][j];
-
+    raw_rows = 0;
+    raw_cols = 0;
+    ld = 0;
+    resize(m.raw_rows, m.raw_cols);
+    std::copy(m.raw.begin(), m.raw.end(), raw.begin());
   }
 
 
   matrix_t & matrix_t::operator=(const matrix_t &m)
   {
 
-    free_raw();
-
-    raw_rows = m.raw_rows;
-    raw_cols = m.raw_cols;
-    raw = matrixNew((int)raw_rows, (int)raw_cols);
-
-    for (size_t i = 0; i < rows(); ++i) {
-      for (size_t j = 0; j < cols(); ++j) {
-        raw[i][j] = m[i][j];
-      }
+    if (this != &m)
+    {
+      resize(m.raw_rows, m.raw_cols);
+      std::copy(m.raw.begin(), m.raw.end(), raw.begin());
     }
 
     return *this;
@@ -512,7 +371,7 @@ namespace hillvallea
     for (size_t i = 0; i < rows(); ++i) {
       for (size_t j = 0; j < cols(); ++j)
       {
-        raw[i][j] += m[i][j];
+        raw[i * ld + j] += m.raw[i * ld + j];
       }
     }
 
@@ -522,35 +381,26 @@ namespace hillvallea
 
 
   // destructor
-  matrix_t::~matrix_t() {
-    free_raw();
-  }
+  matrix_t::~matrix_t() { }
   
-  // free the raw data
-  void matrix_t::free_raw()
-  {
-    if (raw!=NULL)
-    {
-      for (size_t i = 0; i < rows(); ++i) {
-        free(raw[i]);
-      }
-
-      free(raw);
-      
-      raw = NULL;
-      raw_rows = 0;
-      raw_cols = 0;
-    }
-  }
   
-  
-  // clears the matrix
+  // resizes the matrix. The buffer is only reallocated if it has to grow,
+  // the entries are not initialized.
   void matrix_t::resize(const size_t &n, const size_t &m)
   {
-    free_raw();
-    raw = matrixNew( (int)n, (int)m );
+    if (n == raw_rows && m == raw_cols) {
+      return;
+    }
+
     raw_rows = n;
     raw_cols = m;
+    ld = aligned_leading_dimension(m);
+    raw.resize(n * ld);
+
+    raw_row_pointers.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+      raw_row_pointers[i] = &raw[i * ld];
+    }
   }
   
   
@@ -559,7 +409,7 @@ namespace hillvallea
   {
     for (size_t i = 0; i < rows(); ++i) {
       for (size_t j = 0; j < cols(); ++j) {
-        raw[i][j] *= d;
+        raw[i * ld + j] *= d;
       }
     }
   }
@@ -570,7 +420,7 @@ namespace hillvallea
 
     for (size_t i = 0; i < rows(); ++i)
     {
-      result *= raw[i][i];
+      result *= raw[i * ld + i];
     }
 
     return result;
@@ -583,10 +433,10 @@ namespace hillvallea
       for (size_t j = 0; j < cols(); j++)
       {
         if (i != j) {
-          raw[i][j] = 0.0;
+          raw[i * ld + j] = 0.0;
         }
         else {
-          raw[i][j] = sqrt(raw[i][j]);
+          raw[i * ld + j] = sqrt(raw[i * ld + j]);
         }
       }
     }
@@ -600,7 +450,7 @@ namespace hillvallea
     for (size_t i = 0; i < rows(); i++) {
       for (size_t j = 0; j < cols(); j++)
       {
-        t[i][j] = raw[j][i];
+        t[i][j] = raw[j * ld + i];
       }
     }
 
@@ -613,7 +463,7 @@ namespace hillvallea
   double * matrix_t::row(const int i) const
   {
     
-    return raw[i];
+    return const_cast<double *>(&raw[i * ld]);
     
   }
 
@@ -633,22 +483,16 @@ namespace hillvallea
     
   }
 
-  
-  double ** matrix_t::toArray() const
+
+  double * matrix_t::data() const
   {
-    return raw;
+    return const_cast<double *>(raw.data());
   }
 
   
-  void matrix_t::setRaw(double ** raw, const size_t & rows, const size_t & cols)
+  double ** matrix_t::toArray() const
   {
-    
-    free_raw();
-
-    this->raw = raw;
-    raw_rows = rows;
-    raw_cols = cols;
-    
+    return const_cast<double **>(raw_row_pointers.data());
   }
   
   
@@ -661,9 +505,13 @@ namespace hillvallea
   {
     return raw_cols;
   }
+
+  size_t matrix_t::leading_dimension() const
+  {
+    return ld;
+  }
   
   // initializations
-  // scm: if time, improve this by not completely free-ing the memorty
   void matrix_t::reset(const size_t &n, const size_t &m, const double &v)
   {
     resize(n,m);
@@ -674,7 +522,7 @@ namespace hillvallea
   {
     for(size_t i = 0; i < raw_rows; ++i) {
       for(size_t j = 0; j < raw_cols; ++j) {
-        raw[i][j] = v;
+        raw[i * ld + j] = v;
       }
     }
   }
@@ -684,7 +532,7 @@ namespace hillvallea
     this->reset(n,m, 0.0);
     
     for(size_t i = 0; i < std::min(n,m); ++i) {
-      raw[i][i] = 1.0;
+      raw[i * ld + i] = 1.0;
     }
   }
   
@@ -777,7 +625,7 @@ namespace hillvallea
     vec_t result(rows(), 0.0);
 
     for (size_t i = 0; i < rows(); ++i) {
-        result[i] += raw[i][i] * v[i];
+        result[i] += raw[i * ld + i] * v[i];
     }
 
     return result;
@@ -794,7 +642,7 @@ namespace hillvallea
 
     for (size_t i = 0; i < rows(); ++i) {
       for (size_t j = 0; j <= i; ++j) {
-        result[i] += raw[i][j] * v[j];
+        result[i] += raw[i * ld + j] * v[j];
       }
     }
 
@@ -808,13 +656,8 @@ namespace hillvallea
     assert(rows() == cols());
     assert(v.size() == rows());
 
-    vec_t result(rows(), 0.0);
-
-    for (size_t i = 0; i < rows(); ++i) {
-      for (size_t j = 0; j < cols(); ++j) {
-        result[i] += raw[i][j] * v[j];
-      }
-    }
+    vec_t result(rows());
+    matrix_vector_product(*this, v.data(), result.data());
 
     return result;
   }
@@ -11,11 +11,31 @@ github.com/SCMaree/HillVallEA
 */
 
 #include "hillvallea_internal.hpp"
+#include "aligned_allocator.hpp"
 
 
 // start the eda namespace
 namespace hillvallea
 {
+
+  // Vector expressions
+  // The arithmetic operators on vec_t return lightweight expression objects
+  // instead of new vectors. An expression is evaluated element by element, in a
+  // single loop, when it is assigned to (or used to construct) a vec_t. Hence,
+  // x = a + s * (b - a) does not create temporary vectors.
+  //----------------------------------------------------------------------------
+  template <typename E>
+  class vec_expr_t {
+
+  public:
+
+    const E & expr() const { return static_cast<const E &>(*this); }
+
+    // reductions, evaluated without creating the vector
+    double squaredNorm() const;
+    double norm() const;
+
+  };
   
   // Column vectors
   //----------------------------------------------------------------------------
@@ -27,6 +47,7 @@ namespace hillvallea
     vec_t();
     vec_t(const size_t & n);
     vec_t(const size_t & n, const double & val);
+    template <typename E> vec_t(const vec_expr_t<E> & e);
     
     // return as array
     double * toArray();
@@ -38,6 +59,9 @@ namespace hillvallea
     vec_t & operator=(const vec_t& vr);
     vec_t & operator+=(const vec_t& vr);
     vec_t & operator-=(const vec_t& vr);
+    template <typename E> vec_t & operator=(const vec_expr_t<E> & e);
+    template <typename E> vec_t & operator+=(const vec_expr_t<E> & e);
+    template <typename E> vec_t & operator-=(const vec_expr_t<E> & e);
     vec_t & operator+=(const double& val);
     vec_t & operator-=(const double& val);
     vec_t & operator*=(const double& val);
@@ -59,21 +83,238 @@ namespace hillvallea
     
   };
   
-  // overloaded operators for vectors
-  vec_t operator-(const vec_t &pl, const vec_t &pr);
-  vec_t operator-(const double &val, const vec_t &p);
-  vec_t operator-(const vec_t &p, const double &val);
-  vec_t operator+(const vec_t &pl, const vec_t &pr);
-  vec_t operator+(const double &val, const vec_t &p);
-  vec_t operator+(const vec_t &p, const double &val);
-  vec_t operator*(const double &val, const vec_t &p);
-  vec_t operator*(const vec_t &p, const double &val);
-  vec_t operator/(const vec_t &p, const double &val);
   std::ostream &operator<<(std::ostream &os, vec_t const &p);
+
+  // expression nodes
+  //----------------------------------------------------------------------------
+
+  // a vec_t operand, held by reference
+  class vec_ref_t : public vec_expr_t<vec_ref_t> {
+
+  public:
+
+    vec_ref_t(const vec_t & v) : v(v) {}
+    double operator[](const size_t i) const { return v[i]; }
+    size_t size() const { return v.size(); }
+
+  private:
+
+    const vec_t & v;
+
+  };
+
+  // element-wise operations
+  struct vec_add_t { static double apply(const double a, const double b) { return a + b; } };
+  struct vec_sub_t { static double apply(const double a, const double b) { return a - b; } };
+  struct vec_mul_t { static double apply(const double a, const double b) { return a * b; } };
+  struct vec_div_t { static double apply(const double a, const double b) { return a / b; } };
+
+  // l op r, for two vector operands
+  template <typename L, typename R, typename op_t>
+  class vec_binary_t : public vec_expr_t<vec_binary_t<L, R, op_t>> {
+
+  public:
+
+    vec_binary_t(const L & l, const R & r) : l(l), r(r) { assert(l.size() == r.size()); }
+    double operator[](const size_t i) const { return op_t::apply(l[i], r[i]); }
+    size_t size() const { return l.size(); }
+
+  private:
+
+    const L l;
+    const R r;
+
+  };
+
+  // s op r, for a scalar s and a vector operand r
+  template <typename R, typename op_t>
+  class vec_scalar_left_t : public vec_expr_t<vec_scalar_left_t<R, op_t>> {
+
+  public:
+
+    vec_scalar_left_t(const double s, const R & r) : s(s), r(r) {}
+    double operator[](const size_t i) const { return op_t::apply(s, r[i]); }
+    size_t size() const { return r.size(); }
+
+  private:
+
+    const double s;
+    const R r;
+
+  };
+
+  // l op s, for a vector operand l and a scalar s
+  template <typename L, typename op_t>
+  class vec_scalar_right_t : public vec_expr_t<vec_scalar_right_t<L, op_t>> {
+
+  public:
+
+    vec_scalar_right_t(const L & l, const double s) : l(l), s(s) {}
+    double operator[](const size_t i) const { return op_t::apply(l[i], s); }
+    size_t size() const { return l.size(); }
+
+  private:
+
+    const L l;
+    const double s;
+
+  };
+
+  // maps the types that can be a vector operand to their expression node.
+  // Other types have no ::type, which removes the operators below from overload resolution.
+  template <typename T> struct vec_operand_t { };
+
+  template <> struct vec_operand_t<vec_t> {
+    typedef vec_ref_t type;
+    static type wrap(const vec_t & v) { return vec_ref_t(v); }
+  };
+
+  template <> struct vec_operand_t<vec_ref_t> {
+    typedef vec_ref_t type;
+    static type wrap(const vec_ref_t & e) { return e; }
+  };
+
+  template <typename L, typename R, typename op_t> struct vec_operand_t<vec_binary_t<L, R, op_t>> {
+    typedef vec_binary_t<L, R, op_t> type;
+    static type wrap(const type & e) { return e; }
+  };
+
+  template <typename R, typename op_t> struct vec_operand_t<vec_scalar_left_t<R, op_t>> {
+    typedef vec_scalar_left_t<R, op_t> type;
+    static type wrap(const type & e) { return e; }
+  };
+
+  template <typename L, typename op_t> struct vec_operand_t<vec_scalar_right_t<L, op_t>> {
+    typedef vec_scalar_right_t<L, op_t> type;
+    static type wrap(const type & e) { return e; }
+  };
+
+  // overloaded operators for vectors (and vector expressions)
+  //----------------------------------------------------------------------------
+  template <typename A, typename B>
+  vec_binary_t<typename vec_operand_t<A>::type, typename vec_operand_t<B>::type, vec_add_t> operator+(const A & a, const B & b) {
+    return vec_binary_t<typename vec_operand_t<A>::type, typename vec_operand_t<B>::type, vec_add_t>(vec_operand_t<A>::wrap(a), vec_operand_t<B>::wrap(b));
+  }
+
+  template <typename A, typename B>
+  vec_binary_t<typename vec_operand_t<A>::type, typename vec_operand_t<B>::type, vec_sub_t> operator-(const A & a, const B & b) {
+    return vec_binary_t<typename vec_operand_t<A>::type, typename vec_operand_t<B>::type, vec_sub_t>(vec_operand_t<A>::wrap(a), vec_operand_t<B>::wrap(b));
+  }
+
+  template <typename B>
+  vec_scalar_left_t<typename vec_operand_t<B>::type, vec_add_t> operator+(const double & s, const B & b) {
+    return vec_scalar_left_t<typename vec_operand_t<B>::type, vec_add_t>(s, vec_operand_t<B>::wrap(b));
+  }
+
+  template <typename B>
+  vec_scalar_left_t<typename vec_operand_t<B>::type, vec_sub_t> operator-(const double & s, const B & b) {
+    return vec_scalar_left_t<typename vec_operand_t<B>::type, vec_sub_t>(s, vec_operand_t<B>::wrap(b));
+  }
+
+  template <typename B>
+  vec_scalar_left_t<typename vec_operand_t<B>::type, vec_mul_t> operator*(const double & s, const B & b) {
+    return vec_scalar_left_t<typename vec_operand_t<B>::type, vec_mul_t>(s, vec_operand_t<B>::wrap(b));
+  }
+
+  template <typename A>
+  vec_scalar_right_t<typename vec_operand_t<A>::type, vec_add_t> operator+(const A & a, const double & s) {
+    return vec_scalar_right_t<typename vec_operand_t<A>::type, vec_add_t>(vec_operand_t<A>::wrap(a), s);
+  }
+
+  template <typename A>
+  vec_scalar_right_t<typename vec_operand_t<A>::type, vec_sub_t> operator-(const A & a, const double & s) {
+    return vec_scalar_right_t<typename vec_operand_t<A>::type, vec_sub_t>(vec_operand_t<A>::wrap(a), s);
+  }
+
+  template <typename A>
+  vec_scalar_right_t<typename vec_operand_t<A>::type, vec_mul_t> operator*(const A & a, const double & s) {
+    return vec_scalar_right_t<typename vec_operand_t<A>::type, vec_mul_t>(vec_operand_t<A>::wrap(a), s);
+  }
+
+  template <typename A>
+  vec_scalar_right_t<typename vec_operand_t<A>::type, vec_div_t> operator/(const A & a, const double & s) {
+    return vec_scalar_right_t<typename vec_operand_t<A>::type, vec_div_t>(vec_operand_t<A>::wrap(a), s);
+  }
+
+  // evaluation of expressions
+  //----------------------------------------------------------------------------
+  template <typename E>
+  double vec_expr_t<E>::squaredNorm() const
+  {
+    double v = 0;
+    for (size_t i = 0; i < expr().size(); ++i) {
+      double x = expr()[i];
+      v += x * x;
+    }
+    return v;
+  }
+
+  template <typename E>
+  double vec_expr_t<E>::norm() const
+  {
+    return sqrt(squaredNorm());
+  }
+
+  template <typename E>
+  vec_t::vec_t(const vec_expr_t<E> & e) : std::vector<double>(e.expr().size())
+  {
+    const E & x = e.expr();
+    for (size_t i = 0; i < x.size(); ++i) {
+      (*this)[i] = x[i];
+    }
+  }
+
+  // the expression may refer to this vector itself. That is fine, as element i
+  // only depends on element i of the operands, unless this vector has to be resized.
+  template <typename E>
+  vec_t & vec_t::operator=(const vec_expr_t<E> & e)
+  {
+    const E & x = e.expr();
+
+    if (size() != x.size()) {
+      vec_t r(e);
+      swap(r);
+      return *this;
+    }
+
+    for (size_t i = 0; i < x.size(); ++i) {
+      (*this)[i] = x[i];
+    }
+
+    return *this;
+  }
+
+  template <typename E>
+  vec_t & vec_t::operator+=(const vec_expr_t<E> & e)
+  {
+    const E & x = e.expr();
+    assert(size() == x.size());
+
+    for (size_t i = 0; i < x.size(); ++i) {
+      (*this)[i] += x[i];
+    }
+
+    return *this;
+  }
+
+  template <typename E>
+  vec_t & vec_t::operator-=(const vec_expr_t<E> & e)
+  {
+    const E & x = e.expr();
+    assert(size() == x.size());
+
+    for (size_t i = 0; i < x.size(); ++i) {
+      (*this)[i] -= x[i];
+    }
+
+    return *this;
+  }
   
   
   
   // matrices
+  // stored row-major in a single 64-byte aligned buffer. Each row is padded to
+  // leading_dimension() entries, so that every row starts on a cache line.
   //----------------------------------------------------------------------------
   class matrix_t {
     
@@ -94,14 +335,15 @@ namespace hillvallea
     // info
     size_t rows() const;
     size_t cols() const;
+    size_t leading_dimension() const;
     
     
     // accessors
     double *  row(const int i) const;
     double *  operator[](const int i) const;
     double *operator[](const size_t i) const;
-    void setRaw(double ** raw, const size_t & rows, const size_t & cols);
-    double ** toArray() const;
+    double * data() const;      // contiguous buffer, entry (i,j) at data()[i * leading_dimension() + j]
+    double ** toArray() const;  // row pointers into the buffer, for the double** library functions
 
     
     // initializations
@@ -125,11 +367,12 @@ namespace hillvallea
 
   private:
     
-    // the raw data is private, although accessible via toArray();
-    double **raw;
+    // the raw data is private, although accessible via data() and toArray();
+    aligned_vec_t raw;
+    std::vector<double *> raw_row_pointers;
     size_t raw_rows;
     size_t raw_cols;
-    void free_raw();
+    size_t ld;
     
   };
   
@@ -0,0 +1,184 @@
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+
+*/
+
+#include "philox.hpp"
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HILLVALLEA_X86_DISPATCH
+#endif
+
+namespace hillvallea
+{
+
+  static const uint32_t philox_m0 = 0xD2511F53;
+  static const uint32_t philox_m1 = 0xCD9E8D57;
+  static const uint32_t philox_w0 = 0x9E3779B9;
+  static const uint32_t philox_w1 = 0xBB67AE85;
+
+  // Philox4x32-10 encryption of the counter c under key k, in place
+  __attribute__((always_inline))
+  static inline void philox_block(uint32_t c[4], uint32_t k0, uint32_t k1)
+  {
+    for (int round = 0; round < 10; ++round)
+    {
+      uint64_t p0 = (uint64_t) philox_m0 * c[0];
+      uint64_t p1 = (uint64_t) philox_m1 * c[2];
+
+      uint32_t c0 = (uint32_t) (p1 >> 32) ^ c[1] ^ k0;
+      uint32_t c1 = (uint32_t) p1;
+      uint32_t c2 = (uint32_t) (p0 >> 32) ^ c[3] ^ k1;
+      uint32_t c3 = (uint32_t) p0;
+
+      c[0] = c0; c[1] = c1; c[2] = c2; c[3] = c3;
+      k0 += philox_w0;
+      k1 += philox_w1;
+    }
+  }
+
+  // The blocks of the output stream have counter (i, 0), those used to derive
+  // the keys of substreams have counter (id, 1), so the two never coincide.
+  //-------------------------------------------------------------------------------
+  philox_t::philox_t(uint64_t seed)
+  {
+    key[0] = (uint32_t) seed;
+    key[1] = (uint32_t) (seed >> 32);
+    block = 0;
+    position = 4;
+  }
+
+  philox_t::philox_t(uint32_t key0, uint32_t key1)
+  {
+    key[0] = key0;
+    key[1] = key1;
+    block = 0;
+    position = 4;
+  }
+
+  philox_t philox_t::stream(uint64_t id) const
+  {
+    uint32_t c[4] = { (uint32_t) id, (uint32_t) (id >> 32), 1, 0 };
+    philox_block(c, key[0], key[1]);
+    return philox_t(c[0], c[1]);
+  }
+
+  void philox_t::refill()
+  {
+    buffer[0] = (uint32_t) block;
+    buffer[1] = (uint32_t) (block >> 32);
+    buffer[2] = 0;
+    buffer[3] = 0;
+    philox_block(buffer, key[0], key[1]);
+
+    block++;
+    position = 0;
+  }
+
+  philox_t::result_type philox_t::operator()()
+  {
+    if (position == 4) {
+      refill();
+    }
+
+    return buffer[position++];
+  }
+
+  uint64_t philox_t::next_word()
+  {
+    uint64_t high = (*this)();
+    return (high << 32) | (*this)();
+  }
+
+  // whole blocks are computed directly into the output, two words per block.
+  // The blocks are independent, so the loop is vectorized across them.
+  //-------------------------------------------------------------------------------
+  __attribute__((always_inline))
+  static inline void philox_words_kernel(uint64_t * words, size_t number_of_blocks, uint64_t first_block, uint32_t k0, uint32_t k1)
+  {
+    for (size_t b = 0; b < number_of_blocks; ++b)
+    {
+      uint64_t i = first_block + b;
+      uint32_t c[4] = { (uint32_t) i, (uint32_t) (i >> 32), 0, 0 };
+      philox_block(c, k0, k1);
+
+      words[2 * b] = ((uint64_t) c[0] << 32) | c[1];
+      words[2 * b + 1] = ((uint64_t) c[2] << 32) | c[3];
+    }
+  }
+
+  static void philox_words_default(uint64_t * words, size_t number_of_blocks, uint64_t first_block, uint32_t k0, uint32_t k1)
+  {
+    philox_words_kernel(words, number_of_blocks, first_block, k0, k1);
+  }
+
+#ifdef HILLVALLEA_X86_DISPATCH
+
+  __attribute__((target("avx2")))
+  static void philox_words_avx2(uint64_t * words, size_t number_of_blocks, uint64_t first_block, uint32_t k0, uint32_t k1)
+  {
+    philox_words_kernel(words, number_of_blocks, first_block, k0, k1);
+  }
+
+  __attribute__((target("avx512f")))
+  static void philox_words_avx512(uint64_t * words, size_t number_of_blocks, uint64_t first_block, uint32_t k0, uint32_t k1)
+  {
+    philox_words_kernel(words, number_of_blocks, first_block, k0, k1);
+  }
+
+#endif
+
+  typedef void (*philox_words_function_t)(uint64_t *, size_t, uint64_t, uint32_t, uint32_t);
+
+  // picks the kernel once, on first use
+  static philox_words_function_t philox_words()
+  {
+    static const philox_words_function_t function = []()
+    {
+#ifdef HILLVALLEA_X86_DISPATCH
+      __builtin_cpu_init();
+
+      if (__builtin_cpu_supports("avx512f")) {
+        return &philox_words_avx512;
+      }
+
+      if (__builtin_cpu_supports("avx2")) {
+        return &philox_words_avx2;
+      }
+#endif
+      return &philox_words_default;
+    }();
+
+    return function;
+  }
+
+  void philox_t::generate(uint64_t * words, size_t n)
+  {
+    size_t k = 0;
+
+    // finish the current block (whole blocks are only aligned to words at even positions)
+    while (k < n && position != 4) {
+      words[k++] = next_word();
+    }
+
+    if (position == 4)
+    {
+      size_t number_of_blocks = (n - k) / 2;
+      philox_words()(words + k, number_of_blocks, block, key[0], key[1]);
+      block += number_of_blocks;
+      k += 2 * number_of_blocks;
+    }
+
+    for (; k < n; ++k) {
+      words[k] = next_word();
+    }
+  }
+
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace hillvallea
+{
+
+  // Counter-based random number generator
+  // Philox4x32-10 (Salmon et al., 2011): block i of the stream is the encryption of the
+  // counter i under the key of the stream, so blocks can be computed independently and
+  // in any order. Independent substreams are derived from a stream by an identifier,
+  // which gives a generator per (seed, restart, cluster, generation, sample) that does
+  // not depend on which thread uses it, or when.
+  // Satisfies UniformRandomBitGenerator, so it can be used with the std distributions.
+  //-------------------------------------------------------------------------------
+  class philox_t
+  {
+
+  public:
+
+    typedef uint32_t result_type;
+
+    explicit philox_t(uint64_t seed = 0);
+
+    // the substream with the given identifier. It does not depend on, or change,
+    // the position in this stream.
+    philox_t stream(uint64_t id) const;
+
+    // next 32 random bits
+    result_type operator()();
+
+    // next 64 random bits, the same as two calls of operator() (first call in the high bits)
+    uint64_t next_word();
+
+    // the next n words, as n calls of next_word()
+    void generate(uint64_t * words, size_t n);
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+  private:
+
+    philox_t(uint32_t key0, uint32_t key1);
+    void refill();
+
+    uint32_t key[2];
+    uint64_t block;       // index of the next block to compute
+    uint32_t buffer[4];   // the current block
+    unsigned position;    // number of words of buffer used
+
+  };
+
+}
@@ -12,6 +12,11 @@ github.com/SCMaree/HillVallEA
 #include "population.hpp"
 #include "mathfunctions.hpp"
 #include "fitness.h"
+#include "kdtree.hpp"
+#include "population_soa.hpp"
+#include "linalg.hpp"
+#include "normal_generator.hpp"
+#include "threadpool.hpp"
 
 namespace hillvallea
 {
@@ -29,6 +34,15 @@ namespace hillvallea
   //------------------------------------------
   size_t population_t::size() const { return sols.size(); }
   size_t population_t::problem_size() const { return sols[0]->param.size(); }
+
+  solution_pt population_t::new_solution(const size_t problem_size) const
+  {
+    if (solution_pool != nullptr) {
+      return solution_pool->make_solution(problem_size);
+    }
+
+    return std::make_shared<solution_t>(problem_size);
+  }
   
   // Population mean
   void population_t::mean(vec_t & mean) const
@@ -70,44 +84,68 @@ namespace hillvallea
   {
     // Compute the sample covariance
     // use the maximum likelihood estimate (see e.g. wikipedia)
+    // the parameters are first gathered in a contiguous block, which is streamed through
     //-------------------------------------------
-    covariance.reset(problem_size(),problem_size(), 0.0);
-    
-    /* First do the maximum-likelihood estimate from data */
-    for(size_t i = 0; i < problem_size(); i++ )
-    {
-      for(size_t j = i; j < problem_size(); j++ )
-      {
-        for(size_t k = 0; k < sols.size(); k++ ) {
-          covariance[i][j] += (sols[k]->param[i] -mean[i])*(sols[k]->param[j]-mean[j]);
-        }
-        
-        covariance[i][j] /= (double) sols.size();
-      }
-    }
-    
-    for(size_t i = 0; i < problem_size(); i++ )
-      for(size_t j = 0; j < i; j++ )
-        covariance[i][j] = covariance[j][i];
-
+    population_soa_t block;
+    block.gather(*this);
+    block.covariance(mean, covariance);
   }
 
   // population covariance
   void population_t::covariance_univariate(const vec_t & mean, matrix_t & covariance) const
   {
-    // Compute the sample covariance
+    vec_t variances;
+    covariance_univariate(mean, variances);
+
+    covariance.reset(problem_size(), problem_size(), 0.0);
+    for (size_t i = 0; i < problem_size(); i++) {
+      covariance[i][i] = variances[i];
+    }
+  }
+
+  void population_t::covariance_univariate(const vec_t & mean, vec_t & variances) const
+  {
+    // Compute the sample variances
     // use the maximum likelihood estimate (see e.g. wikipedia)
     //-------------------------------------------
-    covariance.reset(problem_size(), problem_size(), 0.0);
+    variances.resize(problem_size());
+    variances.fill(0.0);
 
     /* First do the maximum-likelihood estimate from data */
     for (size_t i = 0; i < problem_size(); i++)
     {
       for (size_t k = 0; k < sols.size(); k++) {
-        covariance[i][i] += (sols[k]->param[i] - mean[i])*(sols[k]->param[i] - mean[i]);
+        variances[i] += (sols[k]->param[i] - mean[i])*(sols[k]->param[i] - mean[i]);
+      }
+
+      variances[i] /= (double)sols.size();
+    }
+  }
+
+  // covariance of the parameters in block, in the order of block
+  void population_t::covariance(const vec_t & mean, const std::vector<size_t> & block, matrix_t & covariance) const
+  {
+    size_t n = block.size();
+    covariance.reset(n, n, 0.0);
+
+    for (size_t k = 0; k < sols.size(); k++)
+    {
+      const vec_t & param = sols[k]->param;
+      for (size_t i = 0; i < n; i++)
+      {
+        double diff_i = param[block[i]] - mean[block[i]];
+        for (size_t j = i; j < n; j++) {
+          covariance[i][j] += diff_i * (param[block[j]] - mean[block[j]]);
+        }
       }
+    }
 
-      covariance[i][i] /= (double)sols.size();
+    for (size_t i = 0; i < n; i++)
+    {
+      for (size_t j = i; j < n; j++) {
+        covariance[i][j] /= (double)sols.size();
+        covariance[j][i] = covariance[i][j];
+      }
     }
   }
 
@@ -115,10 +153,7 @@ namespace hillvallea
   //-------------------------------------------------------------------------------------
   int population_t::evaluate(const fitness_pt fitness_function, const size_t skip_number_of_elites)
   {
-    for(size_t i = skip_number_of_elites; i < sols.size(); ++i) {
-      fitness_function->evaluate(*sols[i]);
-      // assert(isfinite(sols[i]->f));
-    }
+    fitness_function->evaluate_batch(sols, skip_number_of_elites, sols.size());
     
     return ((int) (sols.size()-skip_number_of_elites));
   }
@@ -139,12 +174,12 @@ namespace hillvallea
       // if the solution is not yet initialized, do it now.
       if (sols[i] == nullptr)
       {
-        solution_pt sol = std::make_shared<solution_t>(problem_size);
+        solution_pt sol = new_solution(problem_size);
         sols[i] = sol;
       }
       
       // sample a new solution ...
-      sample_uniform(sols[i]->param, problem_size,lower_param_range,upper_param_range,rng);
+      sample_uniform(sols[i]->param, problem_size,lower_param_range,upper_param_range,*rng);
       
     }
   }
@@ -161,11 +196,11 @@ namespace hillvallea
       
       // if the solution is not yet initialized, do it now.
       if (sols[i] == nullptr) {
-        sols[i] = std::make_shared<solution_t>(problem_size);
+        sols[i] = new_solution(problem_size);
       }
       
       // sample a new solution ...
-      sample_uniform(sols[i]->param, problem_size,lower_param_range,upper_param_range,rng);
+      sample_uniform(sols[i]->param, problem_size,lower_param_range,upper_param_range,*rng);
       
     }
     
@@ -178,88 +213,99 @@ namespace hillvallea
   }
   
   // reject samples of which the nearest d+1 solutions
-  void population_t::fill_with_rejection(const size_t sample_size, const size_t problem_size, double sample_ratio, const std::vector<solution_pt> & previous_sols, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_pt rng)
+  void population_t::fill_with_rejection(const size_t sample_size, const size_t problem_size, double sample_ratio, const std::vector<solution_pt> & previous_sols, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_pt rng, thread_pool_pt thread_pool)
   {
     
-    // resize the solutions vector.
-    sols.resize((size_t) (sample_ratio * sample_size));
-    
-    vec_t dist(previous_sols.size(), 0.0);
-    
+    size_t number_of_samples = (size_t) (sample_ratio * sample_size);
     size_t number_of_nearest_neighbours = problem_size + 1;
-    
-    
-    std::uniform_real_distribution<double> unif(0, 1);
-    
-    // sample solutions and evaluate them
-    for(size_t i = 0; i < sols.size(); ++i)
+
+    // spatial index over the previous solutions
+    kdtree_t tree(problem_size);
+    for (size_t j = 0; j < previous_sols.size(); ++j) {
+      tree.insert(previous_sols[j]->param);
+    }
+
+    // a sample is rejected if its nearest previous solutions all belong to the same cluster.
+    // each distinct distance is represented by its lowest index.
+    auto reject_sample = [&](const solution_t & sol)
     {
-      
-      // if the solution is not yet initialized, do it now.
-      //if (sols[i] == nullptr) {
-        sols[i] = std::make_shared<solution_t>(problem_size);
-      //}
-      
-      // sample a new solution ...
-      sample_uniform(sols[i]->param, problem_size,lower_param_range,upper_param_range,rng);
-      
-      if(previous_sols.size() > 0 )
+      if (previous_sols.size() == 0) {
+        return false;
+      }
+
+      std::vector<size_t> neighbours;
+      vec_t neighbour_dist;
+      tree.nearest(sol.param, number_of_nearest_neighbours, previous_sols.size(), neighbours, neighbour_dist);
+
+      if (neighbours.size() == 0) {
+        return false;
+      }
+
+      int cluster_index = previous_sols[neighbours[0]]->cluster_number; // note, cluster_number == -1 if not in selection, but also count those!
+
+      if (cluster_index == -1) {
+        return false;
+      }
+
+      for (size_t j = 1; j < neighbours.size(); ++j)
       {
-        // for each solution, find the nearest solutions from the previous pop.
-        //-----------------------------------------------------------------------
-        size_t nearest_index = 0, furthest_index = 0;
-        for(size_t j = 0; j < previous_sols.size(); ++j)
-        {
-          dist[j] = sols[i]->param_distance(*previous_sols[j]);
-          
-          if (dist[j] < dist[nearest_index]) {
-            nearest_index = j;
-          }
-          
-          if (dist[j] > dist[furthest_index]) {
-            furthest_index = j;
-          }
-        }
-        
-        bool accept_sample = false;
-        int cluster_index = previous_sols[nearest_index]->cluster_number; // note, cluster_number == -1 if not in selection, but also count those!
-        
-        if(cluster_index == -1)
-        {
-          accept_sample = true;
+        if (cluster_index != previous_sols[neighbours[j]]->cluster_number) {
+          return false;
         }
-        else
+      }
+
+      return true;
+    };
+
+    // samples are drawn and tested in blocks, in parallel if a thread pool is given.
+    // Block b draws from its own substream, so the result does not depend on the
+    // number of threads, or on whether a thread pool is used at all.
+    const size_t block_size = 64;
+    rng_t sampling_rng = rng->stream(rng->next_word());
+    size_t number_of_sampled_blocks = 0;
+
+    sols.clear();
+
+    while (sols.size() < number_of_samples)
+    {
+      size_t number_of_blocks = (number_of_samples - sols.size() + block_size - 1) / block_size;
+      std::vector<std::vector<solution_pt>> accepted(number_of_blocks);
+
+      auto sample_blocks = [&](size_t begin, size_t end)
+      {
+        for (size_t b = begin; b < end; ++b)
         {
-          for(size_t j = 1; j < number_of_nearest_neighbours; ++j)
+          rng_t block_rng = sampling_rng.stream(number_of_sampled_blocks + b);
+          std::uniform_real_distribution<double> unif(0, 1);
+
+          for (size_t k = 0; k < block_size; ++k)
           {
-          
-            size_t old_nearest_index = nearest_index;
-            nearest_index = furthest_index;
-            
-            for (size_t k = 0; k < previous_sols.size(); k++) {
-              
-              if (dist[k] > dist[old_nearest_index] && dist[k] < dist[nearest_index]) {
-                nearest_index = k;
-              }
-            }
-            
-            if(cluster_index != previous_sols[nearest_index]->cluster_number) {
-              accept_sample = true;
-              break;
-            }
+            solution_pt sol = new_solution(problem_size);
+            sample_uniform(sol->param, problem_size, lower_param_range, upper_param_range, block_rng);
 
+            // rejected samples are still accepted with probability 0.1
+            if (!reject_sample(*sol) || unif(block_rng) <= 0.1) {
+              accepted[b].push_back(sol);
+            }
           }
         }
-        
-        // do not accept sample if all neighbours are from the same cluster
-        if(!accept_sample)
-        {
-          // reject sample
-          if(unif(*rng) > 0.1) {
-            i--;
-          }
+      };
+
+      if (thread_pool == nullptr) {
+        sample_blocks(0, number_of_blocks);
+      }
+      else {
+        thread_pool->parallel_for(0, number_of_blocks, sample_blocks, 1);
+      }
+
+      for (size_t b = 0; b < number_of_blocks; ++b)
+      {
+        for (size_t k = 0; k < accepted[b].size() && sols.size() < number_of_samples; ++k) {
+          sols.push_back(accepted[b][k]);
         }
       }
+
+      number_of_sampled_blocks += number_of_blocks;
     }
     
     if (sample_ratio > 1)
@@ -271,8 +317,108 @@ namespace hillvallea
   }
   
   // Fill the given population by normal sampling
+  // All samples are drawn as one block: Z^T (problem_size x samples, one column per
+  // solution) is filled with standard normal samples, solution i drawing from substream
+  // i of the given (generation) stream, and transformed in place to
+  // MatrixRoot * Z^T by one triangular multiply and shifted by the mean, dimension by
+  // dimension. The few samples that are out of range are redrawn from the normal
+  // truncated to the range (truncate_normal_sample), continuing their own substream,
+  // so each solution takes exactly one sample. MatrixRoot must be lower triangular.
+  // Returns the number of samples, and counts the out-of-range ones in number_of_rejected_samples.
   //-------------------------------------------------------------------------------------------------------------------------------
-  int population_t::fill_normal(const size_t sample_size, const size_t problem_size, const vec_t & mean, const matrix_t & MatrixRoot, const vec_t & lower_param_range, const vec_t & upper_param_range, const size_t number_of_elites, rng_pt rng)
+  int population_t::fill_normal(const size_t sample_size, const size_t problem_size, const vec_t & mean, const matrix_t & MatrixRoot, const vec_t & lower_param_range, const vec_t & upper_param_range, const size_t number_of_elites, const rng_t & rng, size_t & number_of_rejected_samples)
+  {
+
+    // Resize the population vector
+    //--------------------------------------------
+    sols.resize(sample_size);
+
+    // the solutions to sample, all but the elites
+    std::vector<size_t> targets;
+    targets.reserve(sols.size());
+
+    for (size_t i = 0; i < sols.size(); ++i)
+    {
+
+      // save the elite (if it is defined)
+      if (i < number_of_elites && sols[i] != nullptr)
+        continue;
+
+      // if the solution is not yet initialized, do it now.
+      if (sols[i] == nullptr)
+      {
+        solution_pt sol = new_solution(problem_size);
+        sols[i] = sol;
+      }
+
+      targets.push_back(i);
+    }
+
+    size_t m = targets.size();
+    if (m == 0) {
+      return 0;
+    }
+
+    // Z^T
+    size_t ld = aligned_leading_dimension(m);
+    aligned_vec_t block(problem_size * ld);
+
+    vec_t z(problem_size);
+
+    for (size_t k = 0; k < m; ++k)
+    {
+      rng_t sample_rng = rng.stream(targets[k]);
+      standard_normals(sample_rng, z.data(), problem_size);
+
+      for (size_t i = 0; i < problem_size; ++i) {
+        block[i * ld + k] = z[i];
+      }
+    }
+
+    // X^T = mean + MatrixRoot * Z^T
+    trmm_lower(MatrixRoot, block.data(), m, ld);
+
+    std::vector<char> out_of_range(m, 0);
+
+    for (size_t i = 0; i < problem_size; ++i)
+    {
+      double * x = &block[i * ld];
+      const double mu = mean[i];
+      const double lower = lower_param_range[i];
+      const double upper = upper_param_range[i];
+
+      for (size_t k = 0; k < m; ++k)
+      {
+        double value = mu + x[k];
+        out_of_range[k] |= (char) ((value < lower) | (value > upper));
+        x[k] = value;
+      }
+    }
+
+    for (size_t k = 0; k < m; ++k)
+    {
+      vec_t & param = sols[targets[k]]->param;
+      param.resize(problem_size);
+
+      for (size_t i = 0; i < problem_size; ++i) {
+        param[i] = block[i * ld + k];
+      }
+
+      if (out_of_range[k])
+      {
+        // the block was transformed in place, so draw z again from the start of the substream
+        rng_t sample_rng = rng.stream(targets[k]);
+        standard_normals(sample_rng, z.data(), problem_size);
+        truncate_normal_sample(param, z, problem_size, mean, MatrixRoot, 1.0, lower_param_range, upper_param_range, sample_rng);
+        number_of_rejected_samples++;
+      }
+    }
+
+    return (int) m;
+  }
+
+
+  int population_t::fill_normal_univariate(const size_t sample_size, const size_t problem_size, const vec_t & mean, const vec_t & cholesky, const vec_t & lower_param_range, const vec_t & upper_param_range, const size_t number_of_elites, const rng_t & rng, size_t & number_of_rejected_samples)
   {
 
     // Resize the population vector
@@ -292,19 +438,26 @@ namespace hillvallea
       // if the solution is not yet initialized, do it now.
       if (sols[i] == nullptr)
       {
-        solution_pt sol = std::make_shared<solution_t>(problem_size);
+        solution_pt sol = new_solution(problem_size);
         sols[i] = sol;
       }
 
-      number_of_samples += sample_normal(sols[i]->param, problem_size, mean, MatrixRoot, lower_param_range, upper_param_range, rng);
+
+      rng_t sample_rng = rng.stream(i);
+      if (sample_normal_univariate(sols[i]->param, problem_size, mean, cholesky, lower_param_range, upper_param_range, sample_rng) > 0) {
+        number_of_rejected_samples++;
+      }
+
+      number_of_samples++;
 
     }
 
     return number_of_samples;
   }
 
-
-  int population_t::fill_normal_univariate(const size_t sample_size, const size_t problem_size, const vec_t & mean, const matrix_t & cholesky, const vec_t & lower_param_range, const vec_t & upper_param_range, const size_t number_of_elites, rng_pt rng)
+  // as fill_normal_univariate, with a block-diagonal cholesky decomposition,
+  // cholesky[b] being the (lower triangular) factor of the parameters in blocks[b]
+  int population_t::fill_normal_blocks(const size_t sample_size, const size_t problem_size, const vec_t & mean, const std::vector<std::vector<size_t>> & blocks, const std::vector<matrix_t> & cholesky, const vec_t & lower_param_range, const vec_t & upper_param_range, const size_t number_of_elites, const rng_t & rng, size_t & number_of_rejected_samples)
   {
 
     // Resize the population vector
@@ -324,12 +477,16 @@ namespace hillvallea
       // if the solution is not yet initialized, do it now.
       if (sols[i] == nullptr)
       {
-        solution_pt sol = std::make_shared<solution_t>(problem_size);
+        solution_pt sol = new_solution(problem_size);
         sols[i] = sol;
       }
 
+      rng_t sample_rng = rng.stream(i);
+      if (sample_normal_blocks(sols[i]->param, problem_size, mean, blocks, cholesky, lower_param_range, upper_param_range, sample_rng) > 0) {
+        number_of_rejected_samples++;
+      }
 
-      number_of_samples += sample_normal_univariate(sols[i]->param, problem_size, mean, cholesky, lower_param_range, upper_param_range, rng);
+      number_of_samples++;
 
     }
 
@@ -387,6 +544,26 @@ namespace hillvallea
   void population_t::sort_on_fitness() {
     std::sort(sols.begin(),sols.end(),solution_t::better_solution_via_pointers);
   }
+
+  // sorts the indices with the same comparisons as above, so the resulting order is identical.
+  // Optimizers use the permutation to keep per-solution side arrays in line with sols.
+  void population_t::sort_on_fitness(std::vector<size_t> & order)
+  {
+    order.resize(sols.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+      return solution_t::better_solution(*sols[a], *sols[b]);
+    });
+
+    std::vector<solution_pt> sorted_sols(sols.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      sorted_sols[i] = sols[order[i]];
+    }
+    sols.swap(sorted_sols);
+  }
   
   // Population Statistics
   //--------------------------------------------------------------------
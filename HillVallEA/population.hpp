@@ -11,6 +11,7 @@ github.com/SCMaree/HillVallEA
 */
 
 #include "solution.hpp"
+#include "solution_pool.hpp"
 
 namespace hillvallea
 {
@@ -29,23 +30,30 @@ namespace hillvallea
     // essential data members
     //------------------------------------------
     std::vector<solution_pt > sols; // solutions
+    solution_pool_pt solution_pool; // if set, new solutions are taken from this pool
     
     // Dimension accessors
     //------------------------------------------
     size_t size() const; // population size
     size_t problem_size() const; // problem size
 
+    // a new solution, from the solution_pool if there is one
+    //------------------------------------------
+    solution_pt new_solution(const size_t problem_size) const;
+
     // initialization
     //------------------------------------------
     void fill_uniform(const size_t sample_size, const size_t problem_size, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_pt rng);
     void fill_greedy_uniform(const size_t sample_size, const size_t problem_size, double sample_ratio, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_pt rng);
-    void fill_with_rejection(const size_t sample_size, const size_t problem_size, double sample_ratio, const std::vector<solution_pt> & previous_sols, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_pt rng);
-    int fill_normal(const size_t sample_size, const size_t problem_size, const vec_t & mean, const matrix_t & MatrixRoot, const vec_t & lower_param_range, const vec_t & upper_param_range, const size_t number_of_elites, rng_pt rng);
-    int fill_normal_univariate(const size_t sample_size, const size_t problem_size, const vec_t & mean, const matrix_t & cholesky, const vec_t & lower_param_range, const vec_t & upper_param_range, const size_t number_of_elites, rng_pt rng);
+    void fill_with_rejection(const size_t sample_size, const size_t problem_size, double sample_ratio, const std::vector<solution_pt> & previous_sols, const vec_t & lower_param_range, const vec_t & upper_param_range, rng_pt rng, thread_pool_pt thread_pool = nullptr);
+    int fill_normal(const size_t sample_size, const size_t problem_size, const vec_t & mean, const matrix_t & MatrixRoot, const vec_t & lower_param_range, const vec_t & upper_param_range, const size_t number_of_elites, const rng_t & rng, size_t & number_of_rejected_samples);
+    int fill_normal_univariate(const size_t sample_size, const size_t problem_size, const vec_t & mean, const vec_t & cholesky, const vec_t & lower_param_range, const vec_t & upper_param_range, const size_t number_of_elites, const rng_t & rng, size_t & number_of_rejected_samples);
+    int fill_normal_blocks(const size_t sample_size, const size_t problem_size, const vec_t & mean, const std::vector<std::vector<size_t>> & blocks, const std::vector<matrix_t> & cholesky, const vec_t & lower_param_range, const vec_t & upper_param_range, const size_t number_of_elites, const rng_t & rng, size_t & number_of_rejected_samples);
 
     // Sorting and ranking
     //------------------------------------------
     void sort_on_fitness();
+    void sort_on_fitness(std::vector<size_t> & order); // also returns the permutation: the k-th sorted solution was sols[order[k]]
 
     // Distribution parameter estimation
     // Maximum likelihood estimation of mean and covariance
@@ -54,6 +62,8 @@ namespace hillvallea
     void weighted_mean(vec_t & mean, const vec_t & weights) const;
     void covariance(const vec_t & mean, matrix_t & covariance) const;
     void covariance_univariate(const vec_t & mean, matrix_t & covariance) const;
+    void covariance_univariate(const vec_t & mean, vec_t & variances) const;  // the diagonal only
+    void covariance(const vec_t & mean, const std::vector<size_t> & block, matrix_t & covariance) const; // of the parameters in block only
 
     // evaluate all solution in the population
     // returns the number of evaluations
@@ -0,0 +1,216 @@
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+
+*/
+
+#include "population_soa.hpp"
+#include "population.hpp"
+#include "distance.hpp"
+#include "linalg.hpp"
+
+namespace hillvallea
+{
+
+  // solution view
+  //------------------------------------------
+  solution_view_t::solution_view_t(double * param, double * f, double * penalty, size_t problem_size)
+  {
+    this->param = param;
+    this->f = f;
+    this->penalty = penalty;
+    this->problem_size = problem_size;
+  }
+
+  double solution_view_t::param_distance(const solution_view_t & other) const
+  {
+    return sqrt(squared_distance(param, other.param, problem_size));
+  }
+
+  double solution_view_t::param_distance(const vec_t & param2) const
+  {
+    return sqrt(squared_distance(param, param2.data(), problem_size));
+  }
+
+  void solution_view_t::copy_to(solution_t & sol) const
+  {
+    sol.param.resize(problem_size);
+    std::copy(param, param + problem_size, sol.param.begin());
+    sol.f = *f;
+    sol.penalty = *penalty;
+  }
+
+  // Constructor
+  population_soa_t::population_soa_t()
+  {
+    number_of_solutions = 0;
+    number_of_parameters = 0;
+    ld = 0;
+  }
+
+  population_soa_t::population_soa_t(const size_t population_size, const size_t problem_size)
+  {
+    resize(population_size, problem_size);
+  }
+
+  // Destructor
+  population_soa_t::~population_soa_t() { }
+
+  // dimensions
+  //------------------------------------------
+  size_t population_soa_t::size() const { return number_of_solutions; }
+  size_t population_soa_t::problem_size() const { return number_of_parameters; }
+  size_t population_soa_t::leading_dimension() const { return ld; }
+
+  void population_soa_t::resize(const size_t population_size, const size_t problem_size)
+  {
+    number_of_solutions = population_size;
+    number_of_parameters = problem_size;
+    ld = aligned_leading_dimension(problem_size);
+
+    params.assign(number_of_solutions * ld, 0.0);
+    f.assign(number_of_solutions, 0.0);
+    penalty.assign(number_of_solutions, 0.0);
+  }
+
+  double * population_soa_t::param(const size_t i) { return &params[i * ld]; }
+  const double * population_soa_t::param(const size_t i) const { return &params[i * ld]; }
+
+  solution_view_t population_soa_t::operator[](const size_t i)
+  {
+    return solution_view_t(param(i), &f[i], &penalty[i], number_of_parameters);
+  }
+
+  // conversion
+  //------------------------------------------
+  void population_soa_t::gather(const population_t & pop)
+  {
+    resize(pop.size(), pop.size() > 0 ? pop.problem_size() : 0);
+
+    for (size_t k = 0; k < number_of_solutions; ++k)
+    {
+      std::copy(pop.sols[k]->param.begin(), pop.sols[k]->param.end(), param(k));
+      f[k] = pop.sols[k]->f;
+      penalty[k] = pop.sols[k]->penalty;
+    }
+  }
+
+  void population_soa_t::scatter(population_t & pop) const
+  {
+    pop.sols.resize(number_of_solutions);
+
+    for (size_t k = 0; k < number_of_solutions; ++k)
+    {
+      if (pop.sols[k] == nullptr) {
+        pop.sols[k] = pop.new_solution(number_of_parameters);
+      }
+
+      pop.sols[k]->param.resize(number_of_parameters);
+      std::copy(param(k), param(k) + number_of_parameters, pop.sols[k]->param.begin());
+      pop.sols[k]->f = f[k];
+      pop.sols[k]->penalty = penalty[k];
+    }
+  }
+
+  // Population mean
+  void population_soa_t::mean(vec_t & mean) const
+  {
+    mean.resize(number_of_parameters);
+    mean.fill(0);
+
+    for (size_t k = 0; k < number_of_solutions; ++k)
+    {
+      const double * x = param(k);
+      for (size_t i = 0; i < number_of_parameters; ++i) {
+        mean[i] += x[i];
+      }
+    }
+
+    mean /= (double) number_of_solutions;
+  }
+
+  // population covariance
+  // The maximum likelihood estimate. The centered parameters are stored in one aligned
+  // block and the upper triangle is formed by a blocked rank-k update (syrk_upper).
+  // Every entry is summed in the same order as in population_t::covariance.
+  void population_soa_t::covariance(const vec_t & mean, matrix_t & covariance) const
+  {
+    size_t n = number_of_parameters;
+    covariance.reset(n, n, 0.0);
+
+    aligned_vec_t centered(number_of_solutions * ld);
+    for (size_t k = 0; k < number_of_solutions; ++k)
+    {
+      const double * x = param(k);
+      double * c = &centered[k * ld];
+      for (size_t i = 0; i < n; ++i) {
+        c[i] = x[i] - mean[i];
+      }
+    }
+
+    syrk_upper(centered.data(), number_of_solutions, n, ld, nullptr, covariance);
+
+    for (size_t i = 0; i < n; i++)
+    {
+      for (size_t j = i; j < n; j++) {
+        covariance[i][j] /= (double) number_of_solutions;
+      }
+    }
+
+    for (size_t i = 0; i < n; i++)
+      for (size_t j = 0; j < i; j++)
+        covariance[i][j] = covariance[j][i];
+  }
+
+  void population_soa_t::covariance_univariate(const vec_t & mean, matrix_t & covariance) const
+  {
+    vec_t variances;
+    covariance_univariate(mean, variances);
+
+    size_t n = number_of_parameters;
+    covariance.reset(n, n, 0.0);
+    for (size_t i = 0; i < n; i++) {
+      covariance[i][i] = variances[i];
+    }
+  }
+
+  void population_soa_t::covariance_univariate(const vec_t & mean, vec_t & variances) const
+  {
+    size_t n = number_of_parameters;
+    variances.resize(n);
+    variances.fill(0.0);
+
+    for (size_t k = 0; k < number_of_solutions; ++k)
+    {
+      const double * x = param(k);
+      for (size_t i = 0; i < n; ++i) {
+        variances[i] += (x[i] - mean[i]) * (x[i] - mean[i]);
+      }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+      variances[i] /= (double) number_of_solutions;
+    }
+  }
+
+  // distances
+  //-------------------------------------------
+  void population_soa_t::param_distances(const double * x, double * distances) const
+  {
+    if (number_of_solutions == 0) {
+      return;
+    }
+
+    squared_distances(x, param(0), number_of_solutions, number_of_parameters, ld, distances);
+
+    for (size_t k = 0; k < number_of_solutions; ++k) {
+      distances[k] = sqrt(distances[k]);
+    }
+  }
+
+}
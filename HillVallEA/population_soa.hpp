@@ -0,0 +1,98 @@
+#pragma once
+
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+*/
+
+#include "hillvallea_internal.hpp"
+#include "param.hpp"
+#include "aligned_allocator.hpp"
+
+namespace hillvallea
+{
+
+  // lightweight handle to a solution stored in a population_soa_t
+  //-----------------------------------------
+  class solution_view_t
+  {
+
+  public:
+
+    solution_view_t(double * param, double * f, double * penalty, size_t problem_size);
+
+    double * param;
+    double * f;
+    double * penalty;
+    size_t problem_size;
+
+    double param_distance(const solution_view_t & other) const;
+    double param_distance(const vec_t & param2) const;
+    void copy_to(solution_t & sol) const;
+
+  };
+
+  // a population in structure-of-arrays layout: one contiguous, 64-byte aligned
+  // block of parameters (one padded row per solution) and separate f/penalty arrays.
+  //-----------------------------------------
+  class population_soa_t
+  {
+
+  public:
+
+    // constructor & destructor
+    //------------------------------------------
+    population_soa_t();
+    population_soa_t(const size_t population_size, const size_t problem_size);
+    ~population_soa_t();
+
+    // essential data members
+    //------------------------------------------
+    aligned_vec_t params; // population_size x leading_dimension
+    vec_t f;
+    vec_t penalty;
+
+    // Dimension accessors
+    //------------------------------------------
+    size_t size() const;
+    size_t problem_size() const;
+    size_t leading_dimension() const;
+    void resize(const size_t population_size, const size_t problem_size);
+
+    // per-solution access
+    //------------------------------------------
+    double * param(const size_t i);
+    const double * param(const size_t i) const;
+    solution_view_t operator[](const size_t i);
+
+    // conversion from and to the solution-based population_t
+    //------------------------------------------
+    void gather(const population_t & pop);
+    void scatter(population_t & pop) const;
+
+    // Distribution parameter estimation
+    // Maximum likelihood estimation of mean and covariance
+    //-------------------------------------------
+    void mean(vec_t & mean) const;
+    void covariance(const vec_t & mean, matrix_t & covariance) const;
+    void covariance_univariate(const vec_t & mean, matrix_t & covariance) const;
+    void covariance_univariate(const vec_t & mean, vec_t & variances) const;  // the diagonal only
+
+    // distances from x to all solutions
+    //-------------------------------------------
+    void param_distances(const double * x, double * distances) const;
+
+  private:
+
+    size_t number_of_solutions;
+    size_t number_of_parameters;
+    size_t ld;
+
+  };
+
+}
@@ -9,6 +9,7 @@ github.com/SCMaree/HillVallEA
 */
 
 #include "solution.hpp"
+#include "distance.hpp"
 
 namespace hillvallea
 {
@@ -22,36 +23,28 @@ namespace hillvallea
     feval_obtained = 0;
     generation_obtained = 0;
     cluster_number = -1;
-    multiplier = 1.0;
-    NormTabDis = 0.0;
   }
 
   solution_t::solution_t(size_t problem_size)
   {
     param.resize(problem_size,0.0);
-    this->param_transformed.resize(problem_size, 0.0);
     penalty = 0.0;
     elite = false;
     time_obtained = 0;
     feval_obtained = 0;
     generation_obtained = 0;
     cluster_number = -1;
-    multiplier = 1.0;
-    NormTabDis = 0.0;
   }
   
   solution_t::solution_t(vec_t param)
   {
     penalty = 0.0;
     this->param = param;
-    this->param_transformed.resize(this->param.size(), 0.0);
     elite = false;
     time_obtained = 0;
     feval_obtained = 0;
     generation_obtained = 0;
     cluster_number = -1;
-    multiplier = 1.0;
-    NormTabDis = 0.0;
   }
   
   solution_t::solution_t(const solution_t & other)
@@ -66,12 +59,20 @@ namespace hillvallea
     this->feval_obtained = other.feval_obtained;
     this->generation_obtained = other.generation_obtained;
     this->cluster_number = other.cluster_number;
-    this->multiplier = other.multiplier;
-    this->param_transformed = other.param_transformed;
-    this->NormTabDis = other.NormTabDis;
   
   }
   
+  void solution_t::reset(size_t problem_size)
+  {
+    param.assign(problem_size, 0.0);
+    penalty = 0.0;
+    elite = false;
+    time_obtained = 0;
+    feval_obtained = 0;
+    generation_obtained = 0;
+    cluster_number = -1;
+  }
+
   // delete solution
   //----------------------------------------------
   solution_t::~solution_t() {}
@@ -104,24 +105,16 @@ namespace hillvallea
     }
   }
   
-  // has sol1 a higher sample probability than sol2?
-  // defined as static!
-  bool solution_t::higher_probability(const std::shared_ptr<solution_t> sol1, const std::shared_ptr<solution_t> sol2)
-  {
-    return (sol1->probability > sol2->probability);
-  }
-  
-  
   // computes the distance to another solution
   //------------------------------------------------------------------------------------
   double solution_t::param_distance(const solution_t & sol2) const
   {
-    return (this->param - sol2.param).norm();
+    return sqrt(squared_distance(this->param.data(), sol2.param.data(), this->param.size()));
   }
 
   double solution_t::param_distance(const vec_t & param2) const
   {
-    return (this->param - param2).norm();
+    return sqrt(squared_distance(this->param.data(), param2.data(), this->param.size()));
   }
   
   
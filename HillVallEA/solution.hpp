@@ -29,6 +29,9 @@ namespace hillvallea
     solution_t(const solution_t & other);
     ~solution_t();
 
+    // re-initialize as solution_t(problem_size), reusing the allocated storage
+    void reset(size_t problem_size);
+
     // essential data members
     //-----------------------------------------
     vec_t param;            // position of the solution, i.e., the coordinate vector
@@ -36,20 +39,10 @@ namespace hillvallea
     double penalty;         // penalty value ( set to > 0 if the solution is infeasible )
     int cluster_number;
     
-    vec_t param_transformed; // for CMSA-ES
-    double multiplier;      // for CMSA-ES
-    double NormTabDis;      // for RS-CMSA
-    
     // Register solution as elite in Hill-Valley Clustering
     //-----------------------------------------
     bool elite;
     
-    // for HGML
-    //-----------------------------------------
-    double probability;    // for spearman rank correlation
-    int fitness_rank;      // for spearman rank correlation
-    int probability_rank;  // for spearman rank correlation
-
     // for performance logging of elites
     //-----------------------------------------
     double time_obtained;
@@ -60,7 +53,6 @@ namespace hillvallea
     //-----------------------------------------
     static bool better_solution_via_pointers(const solution_pt sol1, const solution_pt sol2);
     static bool better_solution(const solution_t & sol1, const solution_t & sol2);
-    static bool higher_probability(const std::shared_ptr<solution_t> sol1, const std::shared_ptr<solution_t> sol2);
     
     // distance to another solution in parameter space
     //-----------------------------------------
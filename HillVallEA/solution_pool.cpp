@@ -0,0 +1,210 @@
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+
+*/
+
+#include "solution_pool.hpp"
+#include <mutex>
+#include <new>
+#include <cstdlib>
+
+namespace hillvallea
+{
+
+  // the arena: storage for solutions and control blocks is allocated in chunks
+  // and only given back to the system when the arena is destroyed.
+  //-------------------------------------------------------------------------------
+  class solution_pool_t::arena_t
+  {
+
+  public:
+
+    static const size_t chunk_size = 64;   // slots per chunk
+    static const size_t block_size = 128;  // bytes per control block slot
+
+    arena_t()
+    {
+      number_of_solutions = 0;
+    }
+
+    ~arena_t()
+    {
+      // every solution holds the arena, so at this point all of them are released
+      for (size_t i = 0; i < free_solutions.size(); ++i) {
+        free_solutions[i]->~solution_t();
+      }
+
+      for (size_t i = 0; i < chunks.size(); ++i) {
+        free(chunks[i]);
+      }
+    }
+
+    solution_t * acquire_solution(size_t problem_size)
+    {
+      solution_t * sol = nullptr;
+      void * slot = nullptr;
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (free_solutions.size() > 0) {
+          sol = free_solutions.back();
+          free_solutions.pop_back();
+        }
+        else {
+          slot = take_slot(free_slots, sizeof(solution_t));
+          number_of_solutions++;
+        }
+      }
+
+      // construct or reset outside the lock
+      if (sol == nullptr) {
+        return new (slot) solution_t(problem_size);
+      }
+
+      sol->reset(problem_size);
+      return sol;
+    }
+
+    void release_solution(solution_t * sol)
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      free_solutions.push_back(sol);
+    }
+
+    void * acquire_block(size_t bytes)
+    {
+      if (bytes > block_size) {
+        return ::operator new(bytes);
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      return take_slot(free_blocks, block_size);
+    }
+
+    void release_block(void * block, size_t bytes)
+    {
+      if (bytes > block_size) {
+        ::operator delete(block);
+        return;
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      free_blocks.push_back(block);
+    }
+
+    size_t number_of_solutions;
+    std::mutex mutex;
+
+  private:
+
+    std::vector<void *> chunks;
+    std::vector<void *> free_slots;             // raw storage for solutions
+    std::vector<void *> free_blocks;            // raw storage for control blocks
+    std::vector<solution_t *> free_solutions;   // constructed, released solutions
+
+    // pop a slot, allocate a new chunk of slots if there is none. Called under the lock.
+    void * take_slot(std::vector<void *> & slots, size_t slot_size)
+    {
+      if (slots.size() == 0)
+      {
+        const size_t alignment = 64;
+        slot_size = ((slot_size + alignment - 1) / alignment) * alignment;
+
+        void * chunk = nullptr;
+        if (posix_memalign(&chunk, alignment, chunk_size * slot_size) != 0) {
+          throw std::bad_alloc();
+        }
+        chunks.push_back(chunk);
+
+        for (size_t i = chunk_size; i > 0; --i) {
+          slots.push_back(static_cast<char *>(chunk) + (i - 1) * slot_size);
+        }
+      }
+
+      void * slot = slots.back();
+      slots.pop_back();
+      return slot;
+    }
+
+  };
+
+  // returns a solution to the arena instead of deleting it
+  //-------------------------------------------------------------------------------
+  class solution_deleter_t
+  {
+
+  public:
+
+    solution_deleter_t(const std::shared_ptr<solution_pool_t::arena_t> & arena) : arena(arena) {}
+
+    void operator()(solution_t * sol) const {
+      arena->release_solution(sol);
+    }
+
+  private:
+
+    std::shared_ptr<solution_pool_t::arena_t> arena;
+
+  };
+
+  // allocates the shared_ptr control blocks in the arena
+  //-------------------------------------------------------------------------------
+  template <typename T>
+  class arena_allocator_t
+  {
+
+  public:
+
+    typedef T value_type;
+
+    arena_allocator_t(const std::shared_ptr<solution_pool_t::arena_t> & arena) : arena(arena) {}
+    template <typename U> arena_allocator_t(const arena_allocator_t<U> & other) : arena(other.arena) {}
+
+    T * allocate(size_t n) {
+      return static_cast<T *>(arena->acquire_block(n * sizeof(T)));
+    }
+
+    void deallocate(T * p, size_t n) {
+      arena->release_block(p, n * sizeof(T));
+    }
+
+    template <typename U> struct rebind { typedef arena_allocator_t<U> other; };
+
+    std::shared_ptr<solution_pool_t::arena_t> arena;
+
+  };
+
+  template <typename T, typename U>
+  bool operator==(const arena_allocator_t<T> & a, const arena_allocator_t<U> & b) { return a.arena == b.arena; }
+
+  template <typename T, typename U>
+  bool operator!=(const arena_allocator_t<T> & a, const arena_allocator_t<U> & b) { return a.arena != b.arena; }
+
+  // solution pool
+  //-------------------------------------------------------------------------------
+  solution_pool_t::solution_pool_t()
+  {
+    arena = std::make_shared<arena_t>();
+  }
+
+  solution_pool_t::~solution_pool_t() {}
+
+  solution_pt solution_pool_t::make_solution(size_t problem_size)
+  {
+    return solution_pt(arena->acquire_solution(problem_size), solution_deleter_t(arena), arena_allocator_t<solution_t>(arena));
+  }
+
+  size_t solution_pool_t::number_of_solutions() const
+  {
+    std::lock_guard<std::mutex> lock(arena->mutex);
+    return arena->number_of_solutions;
+  }
+
+}
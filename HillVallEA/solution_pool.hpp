@@ -0,0 +1,50 @@
+#pragma once
+
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+*/
+
+#include "hillvallea_internal.hpp"
+#include "solution.hpp"
+
+namespace hillvallea
+{
+
+  // Solution pool
+  // Hands out solutions from an arena that is owned by the pool. A solution that
+  // is released (its last solution_pt is dropped) returns to the pool and is
+  // handed out again, reusing its parameter storage. The shared_ptr control
+  // blocks are taken from the same arena. The arena is freed in bulk once the
+  // pool and all solutions it handed out are gone, e.g., at the end of a restart.
+  //
+  // make_solution may be called from multiple threads.
+  //-------------------------------------------------------------------------------
+  class solution_pool_t
+  {
+
+  public:
+
+    solution_pool_t();
+    ~solution_pool_t();
+
+    // equivalent to std::make_shared<solution_t>(problem_size)
+    solution_pt make_solution(size_t problem_size);
+
+    // number of solutions allocated in the arena so far
+    size_t number_of_solutions() const;
+
+    class arena_t;
+
+  private:
+
+    std::shared_ptr<arena_t> arena;
+
+  };
+
+}
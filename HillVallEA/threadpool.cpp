@@ -0,0 +1,194 @@
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+
+*/
+
+#include "threadpool.hpp"
+
+namespace hillvallea
+{
+
+  // the pool (and queue) of the current worker thread, if any
+  static thread_local const thread_pool_t * current_pool = nullptr;
+  static thread_local size_t current_queue_index = 0;
+
+  thread_pool_t::thread_pool_t(size_t number_of_threads)
+  {
+    stop = false;
+    number_of_queued_tasks = 0;
+
+    if (number_of_threads < 1) {
+      number_of_threads = 1;
+    }
+
+    for (size_t i = 0; i < number_of_threads; ++i) {
+      queues.push_back(std::unique_ptr<task_queue_t>(new task_queue_t()));
+    }
+
+    for (size_t i = 1; i < number_of_threads; ++i) {
+      workers.push_back(std::thread(&thread_pool_t::worker_loop, this, i));
+    }
+  }
+
+  thread_pool_t::~thread_pool_t()
+  {
+    {
+      std::unique_lock<std::mutex> lock(sleep_mutex);
+      stop = true;
+    }
+
+    sleep_condition.notify_all();
+
+    for (size_t i = 0; i < workers.size(); ++i) {
+      workers[i].join();
+    }
+  }
+
+  size_t thread_pool_t::number_of_threads() const
+  {
+    return workers.size() + 1;
+  }
+
+  size_t thread_pool_t::own_queue_index() const
+  {
+    if (current_pool == this) {
+      return current_queue_index;
+    }
+
+    return 0;
+  }
+
+  void thread_pool_t::push_task(size_t queue_index, const task_t & task)
+  {
+    {
+      std::unique_lock<std::mutex> lock(queues[queue_index]->mutex);
+      queues[queue_index]->tasks.push_back(task);
+    }
+
+    number_of_queued_tasks++;
+
+    // taking the lock makes sure a worker is either awake or waiting
+    {
+      std::unique_lock<std::mutex> lock(sleep_mutex);
+    }
+    sleep_condition.notify_one();
+  }
+
+  // pop from the back of the own queue (most recent, still in cache),
+  // otherwise steal from the front of the others (oldest, largest chunks first)
+  bool thread_pool_t::take_task(size_t queue_index, task_t & task)
+  {
+    if (number_of_queued_tasks == 0) {
+      return false;
+    }
+
+    for (size_t k = 0; k < queues.size(); ++k)
+    {
+      size_t i = (queue_index + k) % queues.size();
+      std::unique_lock<std::mutex> lock(queues[i]->mutex);
+
+      if (queues[i]->tasks.empty()) {
+        continue;
+      }
+
+      if (k == 0) {
+        task = queues[i]->tasks.back();
+        queues[i]->tasks.pop_back();
+      }
+      else {
+        task = queues[i]->tasks.front();
+        queues[i]->tasks.pop_front();
+      }
+
+      number_of_queued_tasks--;
+      return true;
+    }
+
+    return false;
+  }
+
+  void thread_pool_t::run_task(task_t & task)
+  {
+    task.function();
+    (*task.pending)--;
+  }
+
+  void thread_pool_t::worker_loop(size_t queue_index)
+  {
+    current_pool = this;
+    current_queue_index = queue_index;
+
+    while (true)
+    {
+      task_t task;
+
+      if (take_task(queue_index, task)) {
+        run_task(task);
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(sleep_mutex);
+      sleep_condition.wait(lock, [this] { return stop || number_of_queued_tasks > 0; });
+
+      if (stop) {
+        return;
+      }
+    }
+  }
+
+  void thread_pool_t::parallel_for(size_t begin, size_t end, const std::function<void(size_t, size_t)> & body, size_t grain_size)
+  {
+    if (end <= begin) {
+      return;
+    }
+
+    if (grain_size == 0) {
+      grain_size = std::max((size_t) 1, (end - begin) / (4 * number_of_threads()));
+    }
+
+    // nothing to split
+    if (number_of_threads() == 1 || end - begin <= grain_size) {
+      body(begin, end);
+      return;
+    }
+
+    // queue all but the first chunk, which is done by the calling thread
+    size_t queue_index = own_queue_index();
+    size_t number_of_chunks = (end - begin + grain_size - 1) / grain_size;
+    std::atomic<size_t> pending(number_of_chunks - 1);
+
+    // queued in reverse, so that the owner pops them in order and thieves take the last chunks
+    for (size_t c = number_of_chunks - 1; c > 0; --c)
+    {
+      size_t chunk_begin = begin + c * grain_size;
+      size_t chunk_end = std::min(end, chunk_begin + grain_size);
+
+      task_t task;
+      task.function = [&body, chunk_begin, chunk_end]() { body(chunk_begin, chunk_end); };
+      task.pending = &pending;
+      push_task(queue_index, task);
+    }
+
+    body(begin, std::min(end, begin + grain_size));
+
+    // help out while waiting for the other chunks
+    while (pending > 0)
+    {
+      task_t task;
+
+      if (take_task(queue_index, task)) {
+        run_task(task);
+      }
+      else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+}
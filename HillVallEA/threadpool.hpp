@@ -0,0 +1,76 @@
+#pragma once
+
+/*
+
+HillVallEA
+
+By S.C. Maree
+s.c.maree[at]amc.uva.nl
+github.com/SCMaree/HillVallEA
+
+*/
+
+#include "hillvallea_internal.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+
+namespace hillvallea
+{
+
+  // A work-stealing pool of worker threads
+  // Each worker owns a task queue. It takes tasks from the back of its own
+  // queue, and steals from the front of the other queues when it runs dry.
+  // The calling thread participates in the work, so a pool with
+  // number_of_threads = n starts n-1 workers.
+  //-------------------------------------------------------------------------------
+  class thread_pool_t
+  {
+
+  public:
+
+    thread_pool_t(size_t number_of_threads);
+    ~thread_pool_t();
+
+    size_t number_of_threads() const;
+
+    // calls body(chunk_begin, chunk_end) on disjoint chunks of at most grain_size
+    // elements that cover [begin, end) and returns when all chunks are done.
+    // grain_size = 0 picks a few chunks per thread. The chunks are queued as tasks
+    // that idle threads steal, and a waiting thread executes queued tasks itself,
+    // so parallel_for can be called from within a task.
+    void parallel_for(size_t begin, size_t end, const std::function<void(size_t, size_t)> & body, size_t grain_size = 0);
+
+  private:
+
+    struct task_t
+    {
+      std::function<void()> function;
+      std::atomic<size_t> * pending;
+    };
+
+    struct task_queue_t
+    {
+      std::mutex mutex;
+      std::deque<task_t> tasks;
+    };
+
+    void worker_loop(size_t queue_index);
+    size_t own_queue_index() const;
+    void push_task(size_t queue_index, const task_t & task);
+    bool take_task(size_t queue_index, task_t & task);
+    void run_task(task_t & task);
+
+    // queues[0] is shared by all threads that are not workers of this pool
+    std::vector<std::unique_ptr<task_queue_t>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> number_of_queued_tasks;
+    std::mutex sleep_mutex;
+    std::condition_variable sleep_condition;
+    bool stop;
+
+  };
+
+}
@@ -132,9 +132,11 @@ int main(int argc, char **argv)
   std::vector<int> core_search_alg;
   // core_search_alg.push_back(0);
   core_search_alg.push_back(1); // amalgam-univariate (AMu)
+  // core_search_alg.push_back(2); // block-diagonal (AMaLGaM-Block)
   // core_search_alg.push_back(10);
   // core_search_alg.push_back(20);
   // core_search_alg.push_back(21);
+  // core_search_alg.push_back(30); // limited-memory (LM-MA-ES)
   
   std::vector<int> cluster_alg;
   cluster_alg.push_back(0); // HVC
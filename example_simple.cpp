@@ -99,7 +99,9 @@ int main(int argc, char **argv)
   // HillVallEA Settings
   //-----------------------------------------
   // Type of local optimizer to be used.
-  // 0 = AMaLGaM, 1 = AMaLGaM-Univariate, 20 = iAMaLGaM, 21 = iAMaLGaM-Univariate
+  // 0 = AMaLGaM, 1 = AMaLGaM-Univariate, 2 = AMaLGaM-Block (see fitness_t::get_linkage_blocks),
+  // 20 = iAMaLGaM, 21 = iAMaLGaM-Univariate,
+  // 30 = LM-MA-ES (limited memory, for high dimensions)
   size_t local_optimizer_index = 1; // AMaLGaM-Univariate (1) is suggested
   
   int maximum_number_of_evaluations = 10000; // maximum number of evaluations